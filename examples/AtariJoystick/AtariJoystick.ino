@@ -27,7 +27,6 @@
 #include "Device.h"
 
 #include "AtariSleepyPad.h"
-#include "AtariMapperTask.h"
 
 // Process scheduler.
 TS::Scheduler SchedulerBase;
@@ -46,19 +45,21 @@ Bq25100Driver <Device::BMS::UpdatePeriodMillis,
 // USB driver.
 UsbHidGamepad UsbGamepad{};
 UsbPeripheral UsbDev{};
+UsbSofSync UsbSync(Device::USB::PollLeadFrames);
 
 // Bluetooth driver.
 BLEHidGamepad BleGamepad{};
 BlePeripheral BleDev{};
+BleRadioSync RadioSync{};
 
 // Mega Driver Controller driver.
-using AtariVirtualPadType = AtariSleepyPad<Device::AtariController::Pin, Device::AtariController::WakePin>;
+using AtariVirtualPadType = AtariSleepyPad<Device::AtariController::Pin, Device::AtariController::WakePin, Device::AtariController::PortMap>;
 AtariVirtualPadType AtariVirtualPadWrite{};
 //
 
 //// SOFTWARE TASKS
 // Pad read and notify task.
-AtariMapperTask<AtariVirtualPadType>GamepadMapper(
+GamepadMapperTask<AtariVirtualPadType, Device::AtariController::Mapping, Device::AtariController::Debounce>GamepadMapper(
 	SchedulerBase,
 	AtariVirtualPadWrite,
 	UsbGamepad, BleGamepad,
@@ -68,7 +69,8 @@ AtariMapperTask<AtariVirtualPadType>GamepadMapper(
 LedAnimatorTask PadLights(SchedulerBase, &Led);
 
 // Coordinator task.
-UsbBleCoordinator Coordinator(SchedulerBase, &BMS, &PadLights, &GamepadMapper, UsbDev, BleDev);
+UsbBleCoordinator Coordinator(SchedulerBase, &BMS, &PadLights, &GamepadMapper, UsbDev, BleDev,
+	nullptr, Device::BLE::IdleTimeoutMillis);
 //
 
 void setup()
@@ -105,12 +107,19 @@ void setup()
 		Device::BLE::ConnectionIntervalMax,
 		Device::Name,
 		Device::Version::Name);
+	BleDev.SetTxListener(&GamepadMapper);
+	if (RadioSync.Setup(Device::BLE::RadioNotificationDistance))
+	{
+		GamepadMapper.SetRadioSync(&RadioSync);
+	}
 
 	// USB setup.
 	UsbDev.Setup(Device::Name, Device::Version::Code,
 		Device::USB::UpdatePeriodMillis,
 		Device::USB::ProductId);
 	UsbGamepad.Setup(Device::Name, get_report_callback, set_report_callback);
+	UsbSync.Setup();
+	GamepadMapper.SetUsbSync(&UsbSync);
 
 	// Start the device coordinator.
 	if (!Coordinator.Start())
@@ -142,6 +151,11 @@ void ble_event_callback(ble_evt_t* bleEvent)
 	BleDev.OnBleEventInterrupt(bleEvent);
 }
 
+extern "C" void RADIO_NOTIFICATION_IRQHandler(void)
+{
+	RadioSync.OnRadioNotificationInterrupt();
+}
+
 void advertise_stop_callback()
 {}
 
@@ -165,6 +179,11 @@ void set_report_callback(uint8_t report_id, hid_report_type_t report_type, uint8
 	UsbGamepad.OnSetReportInterrupt(report_id, report_type, buffer, bufsize);
 }
 
+extern "C" void tud_sof_cb(uint32_t frame_count)
+{
+	UsbSync.OnSofInterrupt(frame_count, UsbGamepad.IsReady());
+}
+
 void OnButtonInterrupt()
 {
 	GamepadMapper.OnWakeInterrupt();
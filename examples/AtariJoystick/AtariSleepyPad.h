@@ -5,13 +5,27 @@
 #include <RetroBle.h>
 
 template<typename ControllerPin,
-	uint8_t WakePin>
+	uint8_t WakePin,
+	typename PortMap>
 class AtariSleepyPad : public virtual BatteryManager::ISleep, public AtariJoystick::AtariJoystickVirtualPad<ControllerPin>
 {
 protected:
 	using Base = AtariJoystick::AtariJoystickVirtualPad<ControllerPin>;
 	using Base::PIN_INPUT_MODE;
 
+private:
+	/// <summary>
+	/// All lines in a single port read, gathered in DPadBit order with the button on top.
+	/// </summary>
+	using Lines = PortCapture::Capture<PortMap,
+		(uint8_t)ControllerPin::Up,
+		(uint8_t)ControllerPin::Down,
+		(uint8_t)ControllerPin::Left,
+		(uint8_t)ControllerPin::Right,
+		(uint8_t)ControllerPin::Button>;
+
+	static constexpr uint8_t ButtonBit = 4;
+
 private:
 	void (*WakeInterrupt)() = nullptr;
 
@@ -31,6 +45,18 @@ public:
 		return WakeInterrupt != nullptr;
 	}
 
+	/// <summary>
+	/// Port-wide capture of the joystick state, replaces the per-pin reads.
+	/// Lines are pulled up, active low.
+	/// </summary>
+	void Read()
+	{
+		const uint8_t lines = ~Lines::Read();
+
+		Base::dPad = PortCapture::GetDPad(lines);
+		Base::SetA((lines >> ButtonBit) & 1);
+	}
+
 public:
 	virtual void OnWakeUp() final
 	{
@@ -49,6 +49,22 @@ namespace Device
 		};
 
 		static constexpr uint8_t WakePin = (uint8_t)Pin::Button;
+
+		using PortMap = SeeedXIAOnRF52840::PortMap;
+
+		/// <summary>
+		/// Report the first contact edge, then hold off bounces for 5 samples.
+		/// </summary>
+		using Debounce = DebounceProfile<DebounceModeEnum::Eager, 5>;
+
+		/// <summary>
+		/// Mapped to native RetroArch's RetroPad, targeting the Atari joystick controller.
+		/// </summary>
+		struct Mapping : GamepadMapping::Table
+		{
+			using Buttons = GamepadMapping::ButtonTable<
+				GamepadMapping::Map<GamepadMapping::SourceEnum::A, GAMEPAD_BUTTON_A>>;
+		};
 	}
 
 	namespace BLE
@@ -58,6 +74,17 @@ namespace Device
 
 		static constexpr uint32_t UpdatePeriodMillis = 3;
 
+		/// <summary>
+		/// Sleep after this long connected without activity.
+		/// </summary>
+		static constexpr uint32_t IdleTimeoutMillis = RetroBle::BleConfig::CONNECTED_NO_ACTIVITY_TIMEOUT_MILLIS;
+
+		/// <summary>
+		/// Input is sampled this margin before each connection event.
+		/// UpdatePeriodMillis is only used until the radio notifications lock.
+		/// </summary>
+		static constexpr uint8_t RadioNotificationDistance = NRF_RADIO_NOTIFICATION_DISTANCE_1740US;
+
 		static constexpr RetroBle::BleConfig::Appearance Appearance = RetroBle::BleConfig::Appearance::GamePad;
 
 	}
@@ -66,6 +93,11 @@ namespace Device
 	{
 		static constexpr uint32_t UpdatePeriodMillis = 2;
 
+		/// <summary>
+		/// Input is sampled on the start-of-frame this many frames before each endpoint poll.
+		/// </summary>
+		static constexpr uint8_t PollLeadFrames = 1;
+
 		static constexpr uint16_t ProductId = (uint16_t)RetroBle::Device::ProductIds::AtariJoystick;
 	}
 
@@ -0,0 +1,114 @@
+/*
+* Retro BLE axis kernels tester.
+* Checks the SIMD16 kernels against the scalar ones over the full lane range, and logs the timings.
+* The scalar kernels are checked against a reference on the host, see extras/test/AxisKernelsTest.cpp.
+*
+* Dependencies:
+*	- Core https://github.com/adafruit/Adafruit_nRF52_Arduino
+*/
+
+#include <Arduino.h>
+#include <RetroBle.h>
+
+#include "Device.h"
+
+static constexpr int16_t Scales[] = { INT16_MIN, -1000, -1, 0, 1, 256, XBoxControllerHid::TriggerScale, INT16_MAX };
+static constexpr int16_t Deadzones[] = { 0, 1, XBoxControllerHid::JoyStickDeadZone, 16384, INT16_MAX };
+
+uint32_t Failures = 0;
+
+// Sink for the timing loops, so the kernels aren't optimized out.
+volatile uint32_t Sink = 0;
+
+/// <summary>
+/// Every low lane value, against a high lane that sweeps the range the other way.
+/// </summary>
+template<typename Kernel>
+void Check(const __FlashStringHelper* name, Kernel kernel)
+{
+	uint32_t mismatches = 0;
+	for (int32_t low = INT16_MIN; low <= INT16_MAX; low++)
+	{
+		const int32_t high = -1 - low;
+		const uint32_t pair = (uint32_t)(uint16_t)low | ((uint32_t)(uint16_t)high << 16);
+		if (!kernel(pair))
+		{
+			mismatches++;
+		}
+	}
+
+	if (mismatches > 0)
+	{
+		Failures++;
+		Serial.print(F("FAIL: "));
+		Serial.print(name);
+		Serial.print(F(" mismatches "));
+		Serial.println(mismatches);
+	}
+}
+
+template<typename Kernel>
+void Time(const __FlashStringHelper* name, Kernel kernel)
+{
+	const uint32_t start = micros();
+	for (int32_t low = INT16_MIN; low <= INT16_MAX; low++)
+	{
+		Sink += kernel((uint32_t)(uint16_t)low | ((uint32_t)(uint16_t)(-1 - low) << 16));
+	}
+	const uint32_t duration = micros() - start;
+
+	Serial.print(name);
+	Serial.print(F("\t"));
+	Serial.print(duration);
+	Serial.println(F(" us per 65536 pairs"));
+}
+
+void setup()
+{
+	Serial.begin(Device::Debug::SERIAL_BAUD_RATE);
+
+	// Blocking wait for connection when debug mode is enabled via IDE
+	while (!Serial) delay(10);
+
+	Serial.println(F("Axis Kernels Tester start"));
+
+#if defined(AXIS_KERNELS_SIMD)
+	Check(F("Pack"), [](const uint32_t pair) { return AxisKernels::Pack(AxisKernels::Low(pair), AxisKernels::High(pair)) == AxisKernels::Scalar::Pack(AxisKernels::Low(pair), AxisKernels::High(pair)); });
+	Check(F("Negate"), [](const uint32_t pair) { return AxisKernels::Negate(pair) == AxisKernels::Scalar::Negate(pair); });
+	Check(F("MagnitudeSquared"), [](const uint32_t pair) { return AxisKernels::MagnitudeSquared(pair) == AxisKernels::Scalar::MagnitudeSquared(pair); });
+
+	for (uint8_t i = 0; i < sizeof(Scales) / sizeof(Scales[0]); i++)
+	{
+		const int16_t scale = Scales[i];
+		Check(F("ScaleSigned"), [scale](const uint32_t pair) { return AxisKernels::ScaleSigned<8>(pair, scale) == AxisKernels::Scalar::ScaleSigned<8>(pair, scale); });
+		Check(F("ScaleUnsigned"), [scale](const uint32_t pair) { return AxisKernels::ScaleUnsigned<8>(pair, scale) == AxisKernels::Scalar::ScaleUnsigned<8>(pair, scale); });
+	}
+
+	for (uint8_t i = 0; i < sizeof(Deadzones) / sizeof(Deadzones[0]); i++)
+	{
+		const int16_t deadzone = Deadzones[i];
+		Check(F("Deadzone"), [deadzone](const uint32_t pair) { return AxisKernels::Deadzone(pair, deadzone) == AxisKernels::Scalar::Deadzone(pair, deadzone); });
+	}
+
+	Time(F("ScaleUnsigned SIMD"), [](const uint32_t pair) { return AxisKernels::ScaleUnsigned<XBoxControllerHid::TriggerShift>(pair, XBoxControllerHid::TriggerScale); });
+	Time(F("ScaleUnsigned Scalar"), [](const uint32_t pair) { return AxisKernels::Scalar::ScaleUnsigned<XBoxControllerHid::TriggerShift>(pair, XBoxControllerHid::TriggerScale); });
+	Time(F("Deadzone SIMD"), [](const uint32_t pair) { return AxisKernels::Deadzone(pair, XBoxControllerHid::JoyStickDeadZone); });
+	Time(F("Deadzone Scalar"), [](const uint32_t pair) { return AxisKernels::Scalar::Deadzone(pair, XBoxControllerHid::JoyStickDeadZone); });
+
+	if (Failures > 0)
+	{
+		Serial.print(Failures);
+		Serial.println(F(" failures."));
+	}
+	else
+	{
+		Serial.println(F("All passed."));
+	}
+#else
+	Serial.println(F("No SIMD16 on this target, kernels are scalar."));
+#endif
+}
+
+void loop()
+{
+}
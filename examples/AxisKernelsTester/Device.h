@@ -0,0 +1,20 @@
+// Device.h
+
+#ifndef _DEVICE_h
+#define _DEVICE_h
+
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_NRF52)
+namespace Device
+{
+	namespace Debug
+	{
+		static constexpr uint32_t SERIAL_BAUD_RATE = 115200;
+	}
+};
+#else
+#error Device is not supported for this project.
+#endif
+
+#endif
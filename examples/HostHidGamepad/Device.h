@@ -31,10 +31,32 @@ namespace Device
 			Tx = PIN_SERIAL1_TX
 		};
 
+		static constexpr uint32_t BaudRate = PadBridge::BaudRate;
+		static constexpr uint32_t UpdatePeriodMillis = PadBridge::UpdatePeriodMillis;
+
+		/// <summary>
+		/// Delta frames need the adapter to acknowledge, use Full for receive-only adapters.
+		/// </summary>
+		static constexpr PadBridge::ModeEnum Mode = PadBridge::ModeEnum::Delta;
+
+		/// <summary>
+		/// Forward controller notifications right away, at most once per spacing.
+		/// </summary>
+		static constexpr bool PushOnNotify = true;
+		static constexpr uint32_t PushSpacingMicros = PadBridge::PushSpacingMicros;
 	}
 
 	namespace BLE
 	{
+		/// <summary>
+		/// Concurrent controllers, one per player slot.
+		/// VirtualPadUartInterface forwards a single pad.
+		/// </summary>
+#if defined(PAD_BRIDGE)
+		static constexpr uint8_t PadCount = 4;
+#else
+		static constexpr uint8_t PadCount = 1;
+#endif
 	}
 
 	namespace Unused
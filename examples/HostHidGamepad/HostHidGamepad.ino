@@ -7,9 +7,15 @@
 *   - Reference Central: https://github.com/asukiaaa/nrf52-bluefluit-xbox-controller-practice/tree/master
 *	- Uart interface:  https://github.com/GitMoDu/UartInterface
 *	- Pad abstraction:  https://github.com/GitMoDu/VirtualPad
+*
+* By default, a single controller is forwarded with the VirtualPadUartInterface server.
+* With PAD_BRIDGE defined, up to Device::BLE::PadCount controllers are forwarded on UART, one slot-tagged frame per pad.
+* See PadBridgeProtocol for the framing, the adapter must speak PadBridge too.
+* Where UARTE1 is available, the bridge line runs on EasyDMA (UarteTransport) and the MCU sleeps between frames.
 */
 
 //#define DEBUG
+//#define PAD_BRIDGE
 
 #define _TASK_OO_CALLBACKS
 #include <TScheduler.hpp>
@@ -17,23 +23,35 @@
 #include <RetroBle.h>
 #include "Device.h"
 
+#if !defined(PAD_BRIDGE)
 #include <VirtualPadUartInterface.h>
+#endif
 
 // Process scheduler.
 TS::Scheduler SchedulerBase{};
 // 
 
-// Pad state source.
-HidToVirtualPad<Device::VirtualPadUartInterface::ConfigurationCode> Pad{};
+// Pad state sources, one per player slot.
+using PadType = HidToVirtualPad<Device::VirtualPadUartInterface::ConfigurationCode>;
+PadType Pads[Device::BLE::PadCount]{};
 
 // Host (central).
-BleCentral Central(&Pad);
+BleCentral<Device::BLE::PadCount> Central(Pads);
 
 // Uart server.
+#if !defined(PAD_BRIDGE)
 #if defined(DEBUG1)
-VirtualPadUartInterface::ServerTask<Adafruit_USBD_CDC> UartServer(SchedulerBase, Serial, Pad);
+VirtualPadUartInterface::ServerTask<Adafruit_USBD_CDC> UartServer(SchedulerBase, Serial, Pads[0]);
 #else
-VirtualPadUartInterface::ServerTask<Uart> UartServer(SchedulerBase, Serial1, Pad);
+VirtualPadUartInterface::ServerTask<Uart> UartServer(SchedulerBase, Serial1, Pads[0]);
+#endif
+#elif defined(DEBUG1)
+PadBridgeServerTask<Adafruit_USBD_CDC, PadType, Device::BLE::PadCount> UartServer(SchedulerBase, Serial, Pads, Device::UartInterface::UpdatePeriodMillis);
+#elif defined(NRF_UARTE1)
+UarteTransport Uarte((uint8_t)Device::UartInterface::Pin::Rx, (uint8_t)Device::UartInterface::Pin::Tx);
+PadBridgeServerTask<UarteTransport, PadType, Device::BLE::PadCount> UartServer(SchedulerBase, Uarte, Pads, Device::UartInterface::UpdatePeriodMillis);
+#else
+PadBridgeServerTask<Uart, PadType, Device::BLE::PadCount> UartServer(SchedulerBase, Serial1, Pads, Device::UartInterface::UpdatePeriodMillis);
 #endif
 
 
@@ -46,8 +64,8 @@ void setup()
 	while (!Serial)
 		delay(10);
 
-	Pad.LogFeatures();
-	Pad.LogPropertiesNavigation();
+	Pads[0].LogFeatures();
+	Pads[0].LogPropertiesNavigation();
 #endif
 
 	// Disable unused pins.
@@ -57,14 +75,25 @@ void setup()
 	Central.Setup(connect_callback, disconnect_callback,
 		scan_callback,
 		connection_secured_callback,
-		report_notification_callback);
+		report_notification_callback,
+		ble_event_callback);
 
 
+#if defined(PAD_BRIDGE)
+	if (!UartServer.Setup(Device::UartInterface::BaudRate))
+	{
+		while (true)
+			;;
+	}
+	UartServer.SetMode(Device::UartInterface::Mode);
+	UartServer.SetPush(Device::UartInterface::PushOnNotify, Device::UartInterface::PushSpacingMicros);
+#else
 	if (!UartServer.Setup())
 	{
 		while (true)
 			;;
 	}
+#endif
 
 	// Start pushing out state updates on UART.
 	UartServer.Start();
@@ -74,6 +103,7 @@ void setup()
 #endif
 }
 
+#if !defined(PAD_BRIDGE)
 void loop()
 {
 	if (Serial1.available())
@@ -81,8 +111,49 @@ void loop()
 		UartServer.OnSerialEvent();
 	}
 
+	// Latest controller state, before the server reads it.
+	Pads[0].Update();
+
 	SchedulerBase.execute();
 }
+#else
+void loop()
+{
+	const bool idle = SchedulerBase.execute();
+
+	// Adapter acknowledges, for delta mode, and wake requests.
+	UartServer.OnSerialEvent();
+	if (UartServer.TakeWakeRequest())
+	{
+		Central.Wake();
+	}
+
+	// Forward fresh notifications without waiting for the next period.
+	UartServer.Push();
+
+#if !defined(DEBUG1) && defined(NRF_UARTE1)
+	// Frames go out on DMA, sleep until the next interrupt.
+	if (idle)
+	{
+		waitForEvent();
+	}
+#else
+	(void)idle;
+#endif
+}
+#endif
+
+#if defined(PAD_BRIDGE) && !defined(DEBUG1) && defined(NRF_UARTE1)
+extern "C" void UARTE1_IRQHandler(void)
+{
+	Uarte.OnUarteInterrupt();
+}
+
+extern "C" void TIMER2_IRQHandler(void)
+{
+	Uarte.OnTimerInterrupt();
+}
+#endif
 
 void PinSetup()
 {
@@ -94,6 +165,11 @@ void PinSetup()
 	}
 }
 
+void ble_event_callback(ble_evt_t* bleEvent)
+{
+	Central.OnBleEvent(bleEvent);
+}
+
 void connect_callback(uint16_t conn_handle)
 {
 	Central.OnConnect(conn_handle);
@@ -117,4 +193,7 @@ void connection_secured_callback(uint16_t conn_handle)
 void report_notification_callback(BLEClientCharacteristic* chr, uint8_t* data, uint16_t len)
 {
 	Central.OnReportNotify(chr, data, len);
+#if defined(PAD_BRIDGE)
+	UartServer.OnNotify();
+#endif
 }
@@ -0,0 +1,85 @@
+#ifndef _DEVICE_h
+#define _DEVICE_h
+
+#if defined(ARDUINO_ARCH_NRF52)
+#include <RetroBle.h>
+#include <VirtualPad.h>
+
+namespace Device
+{
+#if defined(DEBUG)
+	namespace Debug
+	{
+		static constexpr uint32_t SERIAL_BAUD_RATE = 115200;
+
+		/// <summary>
+		/// Latency log period.
+		/// </summary>
+		static constexpr uint32_t LogPeriodMillis = 5000;
+	}
+#endif
+	static constexpr char Name[] = "BLE Gamepad Bridge";
+
+	namespace Version
+	{
+		static constexpr uint16_t Code = 0;
+		static constexpr char Name[] = "0";
+	}
+
+	namespace USB
+	{
+		static constexpr uint32_t UpdatePeriodMillis = 1;
+
+		static constexpr uint16_t ProductId = (uint16_t)RetroBle::Device::CustomProductIds::BleToUsbGamepad;
+
+		/// <summary>
+		/// Mapped to native RetroArch's RetroPad, same layout as the source controller.
+		/// </summary>
+		struct Mapping : GamepadMapping::Table
+		{
+			using Buttons = GamepadMapping::ButtonTable<
+				GamepadMapping::Map<GamepadMapping::SourceEnum::A, GAMEPAD_BUTTON_A>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::B, GAMEPAD_BUTTON_B>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::X, GAMEPAD_BUTTON_X>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::Y, GAMEPAD_BUTTON_Y>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::L1, GAMEPAD_BUTTON_TL>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::R1, GAMEPAD_BUTTON_TR>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::L2, GAMEPAD_BUTTON_TL2>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::R2, GAMEPAD_BUTTON_TR2>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::Select, GAMEPAD_BUTTON_SELECT>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::Start, GAMEPAD_BUTTON_START>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::Home, GAMEPAD_BUTTON_MODE>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::L3, GAMEPAD_BUTTON_THUMBL>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::R3, GAMEPAD_BUTTON_THUMBR>>;
+		};
+	}
+
+	namespace Unused
+	{
+		static constexpr uint8_t Pins[] = { };
+	}
+
+	namespace Pad
+	{
+		static constexpr uint32_t ConfigurationCode =
+			VirtualPad::Configuration::GetConfigurationCode(
+				VirtualPad::Configuration::GetFeatureFlags<VirtualPad::Configuration::FeaturesEnum::DPad,
+				VirtualPad::Configuration::FeaturesEnum::Joy1,
+				VirtualPad::Configuration::FeaturesEnum::Joy2,
+				VirtualPad::Configuration::FeaturesEnum::Start, VirtualPad::Configuration::FeaturesEnum::Select,
+				VirtualPad::Configuration::FeaturesEnum::Home, VirtualPad::Configuration::FeaturesEnum::Share,
+				VirtualPad::Configuration::FeaturesEnum::A, VirtualPad::Configuration::FeaturesEnum::B,
+				VirtualPad::Configuration::FeaturesEnum::X, VirtualPad::Configuration::FeaturesEnum::Y,
+				VirtualPad::Configuration::FeaturesEnum::L1, VirtualPad::Configuration::FeaturesEnum::R1,
+				VirtualPad::Configuration::FeaturesEnum::L2, VirtualPad::Configuration::FeaturesEnum::R2,
+				VirtualPad::Configuration::FeaturesEnum::L3, VirtualPad::Configuration::FeaturesEnum::R3>(),
+				VirtualPad::Configuration::NoProperties,
+				VirtualPad::Configuration::NavigationEnum::AB);
+	}
+};
+
+#else
+#error Device is not supported for this project.
+#endif
+
+#endif
@@ -0,0 +1,173 @@
+/*
+* Retro BLE Pad host, bridged to USB (BLE Central to USB HID Gamepad).
+* Any BLE controller becomes a wired pad, for hosts with poor Bluetooth stacks.
+*
+* Dependencies:
+*	- Core https://github.com/Seeed-Studio/OSHW-XIAO-Series
+*	- BLE https://github.com/adafruit/Adafruit_nRF52_Arduino/blob/master/libraries/Bluefruit52Lib/src/bluefruit.h
+*	- USB https://github.com/adafruit/Adafruit_TinyUSB_Arduino
+*	- Pad abstraction:  https://github.com/GitMoDu/VirtualPad
+*
+* Each notification is handed over from the BLE callback, then mapped and queued on the USB endpoint
+* by the USB task, on the very next start-of-frame.
+* See PadBridgeUsb for the latency stats.
+*/
+
+//#define DEBUG
+
+#include <Arduino.h>
+#include <RetroBle.h>
+
+#include "Device.h"
+
+// Pad state source.
+using PadType = HidToVirtualPad<Device::Pad::ConfigurationCode>;
+PadType Pad{};
+
+// Host (central).
+BleCentral<> Central(&Pad);
+
+// USB driver.
+UsbHidGamepad UsbGamepad{};
+UsbPeripheral UsbDev{};
+UsbSofSync UsbSync{};
+
+// BLE to USB bridge.
+PadBridgeUsb<PadType, Device::USB::Mapping> Bridge(UsbGamepad, Pad);
+
+#if defined(DEBUG)
+uint32_t LastLog = 0;
+#endif
+
+void setup()
+{
+#if defined(DEBUG)
+	Serial.begin(Device::Debug::SERIAL_BAUD_RATE);
+
+	// Blocking wait for connection when debug mode is enabled via IDE
+	while (!Serial)
+		delay(10);
+#endif
+
+	// Disable unused pins.
+	PinSetup();
+
+	// USB setup.
+	UsbDev.Setup(Device::Name, Device::Version::Code,
+		Device::USB::UpdatePeriodMillis,
+		Device::USB::ProductId);
+	UsbGamepad.Setup(Device::Name);
+	UsbSync.Setup();
+
+	// Setup BLE Central.
+	Central.Setup(connect_callback, disconnect_callback,
+		scan_callback,
+		connection_secured_callback,
+		report_notification_callback,
+		ble_event_callback);
+
+#if defined(DEBUG)
+	Serial.println(F("Host Usb Gamepad start"));
+#endif
+}
+
+void loop()
+{
+#if defined(DEBUG)
+	if ((millis() - LastLog) >= Device::Debug::LogPeriodMillis)
+	{
+		LastLog = millis();
+		LogLatency();
+	}
+#endif
+
+	// Everything runs from the BLE and USB callbacks.
+	waitForEvent();
+}
+
+void PinSetup()
+{
+	for (uint8_t i = 0; i < sizeof(Device::Unused::Pins); i++)
+	{
+		const uint8_t pin = Device::Unused::Pins[i];
+		pinMode(pin, INPUT);
+		digitalWrite(pin, LOW);
+	}
+}
+
+#if defined(DEBUG)
+void LogLatency()
+{
+	// Snapshot requested on the previous log, taken by the USB task.
+	PadBridgeUsbLatencyStruct latency{};
+	const bool fresh = Bridge.GetLatency(latency);
+	Bridge.RequestLatency();
+	if (!fresh)
+	{
+		return;
+	}
+
+	UsbSofStatsStruct sofStats{};
+	UsbSync.GetStats(sofStats);
+
+	Serial.print(F("Queue (us) n="));
+	Serial.print(latency.Queue.Count);
+	Serial.print(F(" avg="));
+	Serial.print(latency.Queue.Average);
+	Serial.print(F(" p99="));
+	Serial.print(latency.Queue.P99);
+	Serial.print(F(" max="));
+	Serial.println(latency.Queue.Max);
+
+	Serial.print(F("Delivery (us) n="));
+	Serial.print(latency.Delivery.Count);
+	Serial.print(F(" avg="));
+	Serial.print(latency.Delivery.Average);
+	Serial.print(F(" p99="));
+	Serial.print(latency.Delivery.P99);
+	Serial.print(F(" max="));
+	Serial.println(latency.Delivery.Max);
+
+	Serial.print(F("Frames missed "));
+	Serial.print(sofStats.FramesMissed);
+	Serial.print(F("\tOverruns "));
+	Serial.println(Pad.GetOverruns());
+}
+#endif
+
+void ble_event_callback(ble_evt_t* bleEvent)
+{
+	Central.OnBleEvent(bleEvent);
+}
+
+void connect_callback(uint16_t conn_handle)
+{
+	Central.OnConnect(conn_handle);
+}
+
+void disconnect_callback(uint16_t conn_handle, uint8_t reason)
+{
+	Central.OnDisconnect(conn_handle, reason);
+}
+
+void scan_callback(ble_gap_evt_adv_report_t* report)
+{
+	Central.OnScanCallback(report);
+}
+
+void connection_secured_callback(uint16_t conn_handle)
+{
+	Central.OnConnectionSecured(conn_handle);
+}
+
+void report_notification_callback(BLEClientCharacteristic* chr, uint8_t* data, uint16_t len)
+{
+	Central.OnReportNotify(chr, data, len);
+	Bridge.OnNotify();
+}
+
+extern "C" void tud_sof_cb(uint32_t frame_count)
+{
+	UsbSync.OnSofInterrupt(frame_count, UsbGamepad.IsReady());
+	Bridge.OnSofInterrupt();
+}
@@ -8,12 +8,13 @@
 
 namespace Device
 {
-#if defined(DEBUG)
+	/// <summary>
+	/// USB serial, for the debug log and the remap console.
+	/// </summary>
 	namespace Debug
 	{
 		static constexpr uint32_t SERIAL_BAUD_RATE = 115200;
 	}
-#endif
 	static constexpr char Name[] = "Mega Drive Control Pad";
 
 	namespace Version
@@ -51,6 +52,41 @@ namespace Device
 		};
 
 		static constexpr uint8_t WakePin = (uint8_t)Pin::StartC;
+
+		using PortMap = SeeedXIAOnRF52840::PortMap;
+
+		/// <summary>
+		/// Report the first contact edge, then hold off bounces for 5 samples.
+		/// </summary>
+		using Debounce = DebounceProfile<DebounceModeEnum::Eager, 5>;
+
+		/// <summary>
+		/// Mapped to native RetroArch's RetroPad, targeting the Mega Drive 3 button layout.
+		/// See more at https://docs.libretro.com/library/genesis_plus_gx/#joypad
+		/// C is exposed as R3 by the pad.
+		/// </summary>
+		struct Mapping : GamepadMapping::Table
+		{
+			using Buttons = GamepadMapping::ButtonTable<
+				GamepadMapping::Map<GamepadMapping::SourceEnum::A, GAMEPAD_BUTTON_Y>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::B, GAMEPAD_BUTTON_B>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::R3, GAMEPAD_BUTTON_A>,
+				GamepadMapping::Map<GamepadMapping::SourceEnum::Start, GAMEPAD_BUTTON_START>>;
+
+			/// <summary>
+			/// Long press Start to power off.
+			/// </summary>
+			static constexpr GamepadMapping::SourceEnum PowerDownButton = GamepadMapping::SourceEnum::Start;
+			static constexpr uint32_t PowerDownHoldMillis = 5000;
+
+			/// <summary>
+			/// Hold A + B + C to cycle the user remap profiles.
+			/// Only armed once a profile is stored over the remap console, otherwise A + B + C goes through.
+			/// </summary>
+			static constexpr uint8_t RemapProfileCount = 4;
+			static constexpr uint32_t RemapCombo = GAMEPAD_BUTTON_Y | GAMEPAD_BUTTON_B | GAMEPAD_BUTTON_A;
+			static constexpr uint32_t RemapHoldMillis = 2000;
+		};
 	}
 
 	namespace BLE
@@ -60,15 +96,29 @@ namespace Device
 
 		static constexpr uint32_t UpdatePeriodMillis = 3;
 
-		static constexpr RetroBle::BleConfig::Appearance Appearance = RetroBle::BleConfig::Appearance::GamePad;
+		/// <summary>
+		/// Sleep after this long connected without activity.
+		/// </summary>
+		static constexpr uint32_t IdleTimeoutMillis = RetroBle::BleConfig::CONNECTED_NO_ACTIVITY_TIMEOUT_MILLIS;
+
+		/// <summary>
+		/// Input is sampled this margin before each connection event.
+		/// UpdatePeriodMillis is only used until the radio notifications lock.
+		/// </summary>
+		static constexpr uint8_t RadioNotificationDistance = NRF_RADIO_NOTIFICATION_DISTANCE_1740US;
 
-		static constexpr uint32_t LONG_PRESS_POWER_OFF_PERIOD_MILLIS = 5000;
+		static constexpr RetroBle::BleConfig::Appearance Appearance = RetroBle::BleConfig::Appearance::GamePad;
 	}
 
 	namespace USB
 	{
 		static constexpr uint32_t UpdatePeriodMillis = 2;
 
+		/// <summary>
+		/// Input is sampled on the start-of-frame this many frames before each endpoint poll.
+		/// </summary>
+		static constexpr uint8_t PollLeadFrames = 1;
+
 		static constexpr uint16_t ProductId = (uint16_t)RetroBle::Device::ProductIds::MegaDrive3Button;
 	}
 
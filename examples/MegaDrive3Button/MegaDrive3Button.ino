@@ -6,6 +6,7 @@
 *	- BLE interface with ~12ms update period.
 *	- Battery level state.
 *	- State LEDs.
+*	- User remap profiles, authored over USB serial (see GamepadRemapConsole) and cycled by holding A + B + C.
 *
 * Dependencies:
 *	- Core https://github.com/Seeed-Studio/OSHW-XIAO-Series
@@ -27,7 +28,6 @@
 #include "Device.h"
 
 #include "MegaDriveSleepyPad.h"
-#include "MegaDriveMapperTask.h"
 
 // Process scheduler.
 TS::Scheduler SchedulerBase;
@@ -46,36 +46,42 @@ Bq25100Driver <Device::BMS::UpdatePeriodMillis,
 // USB driver.
 UsbHidGamepad UsbGamepad{};
 UsbPeripheral UsbDev{};
+UsbSofSync UsbSync(Device::USB::PollLeadFrames);
 
 // Bluetooth driver.
 BLEHidGamepad BleGamepad{};
 BlePeripheral BleDev{};
+BleRadioSync RadioSync{};
 
 // Mega Driver Controller driver.
-using MegaDriveVirtualPadType = MegaDriveSleepyPad<Device::MegaDriveController::Pin, Device::MegaDriveController::WakePin>;
+using MegaDriveVirtualPadType = MegaDriveSleepyPad<Device::MegaDriveController::Pin, Device::MegaDriveController::WakePin, Device::MegaDriveController::PortMap>;
 MegaDriveVirtualPadType MegaDriveVirtualPadWrite{};
 //
 
 //// SOFTWARE TASKS
 // Pad read and notify task.
-MegaDriveMapperTask<MegaDriveVirtualPadType, Device::BLE::LONG_PRESS_POWER_OFF_PERIOD_MILLIS>GamepadMapper(
+GamepadMapperTask<MegaDriveVirtualPadType, Device::MegaDriveController::Mapping, Device::MegaDriveController::Debounce>GamepadMapper(
 	SchedulerBase,
 	MegaDriveVirtualPadWrite,
 	UsbGamepad, BleGamepad,
 	Device::BLE::UpdatePeriodMillis);
 
+// User remap profiles, authored over USB serial.
+GamepadRemapConsole RemapConsole(SchedulerBase, Serial, GamepadMapper.GetRemap());
+
 // LED animation task.
 LedAnimatorTask PadLights(SchedulerBase, &Led);
 
 // Coordinator task.
-UsbBleCoordinator Coordinator(SchedulerBase, &BMS, &PadLights, &GamepadMapper, UsbDev, BleDev);
+UsbBleCoordinator Coordinator(SchedulerBase, &BMS, &PadLights, &GamepadMapper, UsbDev, BleDev,
+	nullptr, Device::BLE::IdleTimeoutMillis);
 //
 
 void setup()
 {
-#if defined(DEBUG)
 	Serial.begin(Device::Debug::SERIAL_BAUD_RATE);
 
+#if defined(DEBUG)
 	// Blocking wait for connection when debug mode is enabled via IDE
 	while (!Serial) delay(10);
 
@@ -105,12 +111,21 @@ void setup()
 		Device::BLE::ConnectionIntervalMax,
 		Device::Name,
 		Device::Version::Name);
+	BleDev.SetTxListener(&GamepadMapper);
+	GamepadMapper.SetupRemap();
+	RemapConsole.Start();
+	if (RadioSync.Setup(Device::BLE::RadioNotificationDistance))
+	{
+		GamepadMapper.SetRadioSync(&RadioSync);
+	}
 
 	// USB setup.
 	UsbDev.Setup(Device::Name, Device::Version::Code,
 		Device::USB::UpdatePeriodMillis,
 		Device::USB::ProductId);
 	UsbGamepad.Setup(Device::Name, get_report_callback, set_report_callback);
+	UsbSync.Setup();
+	GamepadMapper.SetUsbSync(&UsbSync);
 
 	// Start the device coordinator.
 	if (!Coordinator.Start())
@@ -142,6 +157,11 @@ void ble_event_callback(ble_evt_t* bleEvent)
 	BleDev.OnBleEventInterrupt(bleEvent);
 }
 
+extern "C" void RADIO_NOTIFICATION_IRQHandler(void)
+{
+	RadioSync.OnRadioNotificationInterrupt();
+}
+
 void advertise_stop_callback()
 {}
 
@@ -165,6 +185,11 @@ void set_report_callback(uint8_t report_id, hid_report_type_t report_type, uint8
 	UsbGamepad.OnSetReportInterrupt(report_id, report_type, buffer, bufsize);
 }
 
+extern "C" void tud_sof_cb(uint32_t frame_count)
+{
+	UsbSync.OnSofInterrupt(frame_count, UsbGamepad.IsReady());
+}
+
 void OnButtonInterrupt()
 {
 	GamepadMapper.OnWakeInterrupt();
@@ -7,7 +7,8 @@
 #include <RetroBle.h>
 
 template<typename ControllerPin,
-	const uint8_t WakePin>
+	const uint8_t WakePin,
+	typename PortMap>
 class MegaDriveSleepyPad 
 	: public virtual BatteryManager::ISleep
 	, public MegaDriveController::MegaDriveControllerVirtualPad<ControllerPin>
@@ -16,6 +17,30 @@ protected:
 	using Base = MegaDriveController::MegaDriveControllerVirtualPad<ControllerPin>;
 	using Base::PIN_INPUT_MODE;
 
+private:
+	/// <summary>
+	/// Controller multiplexer settle time after toggling Select.
+	/// </summary>
+	static constexpr uint32_t SelectSettleMicros = 2;
+
+	/// <summary>
+	/// All data lines in a single port read.
+	/// With Select high: Up, Down, Left, Right, B, C.
+	/// With Select low: Up, Down, -, -, A, Start.
+	/// </summary>
+	using Lines = PortCapture::Capture<PortMap,
+		(uint8_t)ControllerPin::Up,
+		(uint8_t)ControllerPin::Down,
+		(uint8_t)ControllerPin::InfoLeft,
+		(uint8_t)ControllerPin::InfoRight,
+		(uint8_t)ControllerPin::AB,
+		(uint8_t)ControllerPin::StartC>;
+
+	using SelectLine = PortCapture::Output<PortMap, (uint8_t)ControllerPin::Select>;
+
+	static constexpr uint8_t ABBit = 4;
+	static constexpr uint8_t StartCBit = 5;
+
 private:
 	void (*WakeInterrupt)() = nullptr;
 
@@ -34,6 +59,31 @@ public:
 		return WakeInterrupt != nullptr;
 	}
 
+	/// <summary>
+	/// Port-wide capture of the controller state, one port read per Select phase.
+	/// Lines are pulled up, active low.
+	/// C is exposed as R3, as consumed by the mapper.
+	/// </summary>
+	void Read()
+	{
+		SelectLine::Set(true);
+		delayMicroseconds(SelectSettleMicros);
+		const uint8_t high = ~Lines::Read();
+
+		SelectLine::Set(false);
+		delayMicroseconds(SelectSettleMicros);
+		const uint8_t low = ~Lines::Read();
+
+		// Idle Select high.
+		SelectLine::Set(true);
+
+		Base::dPad = PortCapture::GetDPad(high);
+		Base::SetB((high >> ABBit) & 1);
+		Base::SetR3((high >> StartCBit) & 1);
+		Base::SetA((low >> ABBit) & 1);
+		Base::SetStart((low >> StartCBit) & 1);
+	}
+
 public:
 	virtual void OnWakeUp() final
 	{
@@ -0,0 +1,151 @@
+// AxisKernelsTest.cpp
+// Host test for the scalar axis kernels, against a wide integer reference over the full lane range.
+// The SIMD kernels are checked against the scalar ones on target, see examples/AxisKernelsTester.
+// Build and run from the repository root:
+//	g++ -std=c++11 -Wall -Isrc extras/test/AxisKernelsTest.cpp -o AxisKernelsTest && ./AxisKernelsTest
+
+#include <stdio.h>
+
+#include "Analog/AxisKernels.h"
+
+using namespace AxisKernels;
+
+static uint16_t Failures = 0;
+
+static void Check(const bool condition, const char* what)
+{
+	if (!condition)
+	{
+		Failures++;
+		printf("FAIL: %s\n", what);
+	}
+}
+
+static int64_t Clamp(const int64_t value, const int64_t min, const int64_t max)
+{
+	return value < min ? min : (value > max ? max : value);
+}
+
+static uint32_t ReferencePack(const int64_t low, const int64_t high)
+{
+	return (uint32_t)(low & 0xFFFF) | ((uint32_t)(high & 0xFFFF) << 16);
+}
+
+static int64_t ReferenceDeadzone(const int64_t value, const int64_t deadzone)
+{
+	if (value > deadzone)
+	{
+		return value - deadzone;
+	}
+	else if (value < -deadzone)
+	{
+		return value + deadzone;
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Every low lane value, against a high lane that sweeps the range the other way.
+/// </summary>
+template<typename Kernel>
+static const bool Sweep(Kernel kernel)
+{
+	bool match = true;
+	for (int32_t low = INT16_MIN; low <= INT16_MAX; low++)
+	{
+		const int32_t high = -1 - low;
+		match &= kernel(low, high);
+	}
+
+	return match;
+}
+
+static void TestLanes()
+{
+	Check(Sweep([](const int32_t low, const int32_t high)
+		{
+			const uint32_t pair = Scalar::Pack(low, high);
+			return Low(pair) == low && High(pair) == high && pair == ReferencePack(low, high);
+		}), "Pack");
+
+	Check(Sweep([](const int32_t low, const int32_t high)
+		{
+			const uint8_t data[4] = { (uint8_t)low, (uint8_t)(low >> 8), (uint8_t)high, (uint8_t)(high >> 8) };
+			return Load(data) == ReferencePack(low, high);
+		}), "Load");
+
+	Check(Sweep([](const int32_t low, const int32_t high)
+		{
+			// Offset binary, i.e. unsigned axis centered at 32768.
+			const uint32_t pair = FlipBias(ReferencePack(low, high));
+			return Low(pair) == (int16_t)((uint16_t)low - 32768) && High(pair) == (int16_t)((uint16_t)high - 32768);
+		}), "FlipBias");
+
+	Check(Sweep([](const int32_t low, const int32_t high)
+		{
+			const uint32_t pair = InvertHigh(ReferencePack(low, high));
+			return Low(pair) == low && High(pair) == (-1 - high);
+		}), "InvertHigh");
+}
+
+static void TestKernels()
+{
+	Check(Sweep([](const int32_t low, const int32_t high)
+		{
+			return Scalar::Negate(ReferencePack(low, high)) == ReferencePack(Clamp(-low, INT16_MIN, INT16_MAX), Clamp(-high, INT16_MIN, INT16_MAX));
+		}), "Negate");
+
+	Check(Sweep([](const int32_t low, const int32_t high)
+		{
+			return Scalar::MagnitudeSquared(ReferencePack(low, high)) == (uint32_t)(((int64_t)low * low) + ((int64_t)high * high));
+		}), "MagnitudeSquared");
+
+	// Worst case magnitude, both lanes at the negative limit.
+	Check(Scalar::MagnitudeSquared(ReferencePack(INT16_MIN, INT16_MIN)) == 0x80000000, "MagnitudeSquared limit");
+
+	static constexpr int16_t Scales[] = { INT16_MIN, -1000, -1, 0, 1, 256, 16400, INT16_MAX };
+	for (uint8_t i = 0; i < sizeof(Scales) / sizeof(Scales[0]); i++)
+	{
+		const int16_t scale = Scales[i];
+
+		Check(Sweep([scale](const int32_t low, const int32_t high)
+			{
+				return Scalar::ScaleSigned<8>(ReferencePack(low, high), scale)
+					== ReferencePack(Clamp(((int64_t)low * scale) >> 8, INT16_MIN, INT16_MAX), Clamp(((int64_t)high * scale) >> 8, INT16_MIN, INT16_MAX));
+			}), "ScaleSigned");
+
+		Check(Sweep([scale](const int32_t low, const int32_t high)
+			{
+				return Scalar::ScaleUnsigned<8>(ReferencePack(low, high), scale)
+					== ReferencePack(Clamp(((int64_t)low * scale) >> 8, 0, UINT16_MAX), Clamp(((int64_t)high * scale) >> 8, 0, UINT16_MAX));
+			}), "ScaleUnsigned");
+	}
+
+	static constexpr int16_t Deadzones[] = { 0, 1, 1500, 16384, INT16_MAX };
+	for (uint8_t i = 0; i < sizeof(Deadzones) / sizeof(Deadzones[0]); i++)
+	{
+		const int16_t deadzone = Deadzones[i];
+
+		Check(Sweep([deadzone](const int32_t low, const int32_t high)
+			{
+				return Scalar::Deadzone(ReferencePack(low, high), deadzone)
+					== ReferencePack(ReferenceDeadzone(low, deadzone), ReferenceDeadzone(high, deadzone));
+			}), "Deadzone");
+	}
+}
+
+int main()
+{
+	TestLanes();
+	TestKernels();
+
+	if (Failures > 0)
+	{
+		printf("%u failures.\n", Failures);
+		return 1;
+	}
+
+	printf("All passed.\n");
+	return 0;
+}
@@ -0,0 +1,208 @@
+// HidReportParserTest.cpp
+// Host test for the HID report descriptor compiler, with real controller descriptors.
+// Build and run from the repository root:
+//	g++ -std=c++11 -Wall -Isrc extras/test/HidReportParserTest.cpp -o HidReportParserTest && ./HidReportParserTest
+
+#include <stdio.h>
+#include <string.h>
+
+#include "HidHost/HidReportParser.h"
+#include "HidHost/XBoxControllerHid.h"
+
+#include "TestDescriptors.h"
+
+using namespace HidReport;
+
+static uint16_t Failures = 0;
+
+static void Check(const bool condition, const char* what)
+{
+	if (!condition)
+	{
+		Failures++;
+		printf("FAIL: %s\n", what);
+	}
+}
+
+static const FieldStruct* Find(const ProgramStruct& program, const TargetEnum target)
+{
+	for (uint8_t i = 0; i < program.Count; i++)
+	{
+		if (program.Fields[i].Target == target)
+		{
+			return &program.Fields[i];
+		}
+	}
+
+	return nullptr;
+}
+
+static const bool HasField(const ProgramStruct& program, const TargetEnum target, const uint16_t bitOffset, const uint8_t bitSize)
+{
+	const FieldStruct* field = Find(program, target);
+
+	return field != nullptr
+		&& field->BitOffset == bitOffset
+		&& field->BitSize == bitSize;
+}
+
+/// <summary>
+/// Set targets in a report with a single bit set.
+/// </summary>
+static const uint32_t GetPressed(const ProgramStruct& program, const uint8_t* report)
+{
+	uint32_t pressed = 0;
+	for (uint8_t i = 0; i < program.Count; i++)
+	{
+		const FieldStruct& field = program.Fields[i];
+		if (field.BitSize == 1
+			&& Extract(report, field) != 0)
+		{
+			pressed |= (uint32_t)1 << (uint8_t)field.Target;
+		}
+	}
+
+	return pressed;
+}
+
+static void CheckXBoxButton(const ProgramStruct& program, const uint8_t index, const uint8_t bit, const TargetEnum target, const char* what)
+{
+	uint8_t report[XBoxControllerHid::DataSize]{};
+	report[index] = 1 << bit;
+
+	Check(GetPressed(program, report) == ((uint32_t)1 << (uint8_t)target), what);
+}
+
+/// <summary>
+/// The compiled program must agree with the fixed XBox layout.
+/// </summary>
+static void TestXBox()
+{
+	ProgramStruct program{};
+	Check(Parser::Compile(XBoxDescriptor, sizeof(XBoxDescriptor), program), "XBox compiles");
+	Check(program.ReportId == 1, "XBox input report 1");
+	Check(program.ReportSize == XBoxControllerHid::DataSize, "XBox report size");
+
+	Check(HasField(program, TargetEnum::Joy1X, 0, 16), "XBox Joy1X");
+	Check(HasField(program, TargetEnum::Joy1Y, 16, 16), "XBox Joy1Y");
+	Check(HasField(program, TargetEnum::Joy2X, 32, 16), "XBox Joy2X");
+	Check(HasField(program, TargetEnum::Joy2Y, 48, 16), "XBox Joy2Y");
+	Check(HasField(program, TargetEnum::L2, 64, 10), "XBox L2");
+	Check(HasField(program, TargetEnum::R2, 80, 10), "XBox R2");
+	Check(HasField(program, TargetEnum::DPad, 96, 4), "XBox DPad");
+	Check(Find(program, TargetEnum::L2Digital) == nullptr, "XBox no digital L2");
+	Check(Find(program, TargetEnum::R2Digital) == nullptr, "XBox no digital R2");
+
+	// Unsigned 16 bit axes, declared with a 4 byte maximum.
+	const FieldStruct* joy1X = Find(program, TargetEnum::Joy1X);
+	Check(joy1X != nullptr && joy1X->LogicalMin == 0 && joy1X->LogicalMax == UINT16_MAX, "XBox axis range");
+
+	// Triggers, full range and within rounding of the fixed-point XBox scale.
+	const FieldStruct* l2 = Find(program, TargetEnum::L2);
+	if (l2 != nullptr)
+	{
+		bool triggerMatch = true;
+		for (uint16_t value = 0; value <= XBoxControllerHid::TriggerMax; value++)
+		{
+			uint32_t fixed = ((uint32_t)value * XBoxControllerHid::TriggerScale) >> XBoxControllerHid::TriggerShift;
+			if (fixed > UINT16_MAX)
+			{
+				fixed = UINT16_MAX;
+			}
+
+			const int32_t difference = (int32_t)GetUnsigned(*l2, value) - (int32_t)fixed;
+			triggerMatch &= difference >= -1 && difference <= 1;
+		}
+		Check(triggerMatch, "XBox trigger scale");
+		Check(GetUnsigned(*l2, XBoxControllerHid::TriggerMax) == UINT16_MAX, "XBox trigger full range");
+	}
+
+	// Hat is already in VirtualPad order, 0 is centered.
+	const FieldStruct* dPad = Find(program, TargetEnum::DPad);
+	if (dPad != nullptr)
+	{
+		bool hatMatch = GetHat(*dPad, (uint8_t)XBoxControllerHid::DPad::None) == 0;
+		for (uint8_t value = (uint8_t)XBoxControllerHid::DPad::Up; value < (uint8_t)XBoxControllerHid::DPad::DPadEnumCount; value++)
+		{
+			hatMatch &= GetHat(*dPad, value) == value;
+		}
+		Check(hatMatch, "XBox hat");
+	}
+
+	CheckXBoxButton(program, 13, (uint8_t)XBoxControllerHid::Buttons1::A, TargetEnum::A, "XBox A");
+	CheckXBoxButton(program, 13, (uint8_t)XBoxControllerHid::Buttons1::B, TargetEnum::B, "XBox B");
+	CheckXBoxButton(program, 13, (uint8_t)XBoxControllerHid::Buttons1::X, TargetEnum::X, "XBox X");
+	CheckXBoxButton(program, 13, (uint8_t)XBoxControllerHid::Buttons1::Y, TargetEnum::Y, "XBox Y");
+	CheckXBoxButton(program, 13, (uint8_t)XBoxControllerHid::Buttons1::L1, TargetEnum::L1, "XBox L1");
+	CheckXBoxButton(program, 13, (uint8_t)XBoxControllerHid::Buttons1::R1, TargetEnum::R1, "XBox R1");
+	CheckXBoxButton(program, 14, (uint8_t)XBoxControllerHid::Buttons2::Select, TargetEnum::Select, "XBox Select");
+	CheckXBoxButton(program, 14, (uint8_t)XBoxControllerHid::Buttons2::Start, TargetEnum::Start, "XBox Start");
+	CheckXBoxButton(program, 14, (uint8_t)XBoxControllerHid::Buttons2::Home, TargetEnum::Home, "XBox Home");
+	CheckXBoxButton(program, 14, (uint8_t)XBoxControllerHid::Buttons2::L3, TargetEnum::L3, "XBox L3");
+	CheckXBoxButton(program, 14, (uint8_t)XBoxControllerHid::Buttons2::R3, TargetEnum::R3, "XBox R3");
+	CheckXBoxButton(program, 15, (uint8_t)XBoxControllerHid::Buttons3::Share, TargetEnum::Share, "XBox Share");
+
+	Check(XBoxControllerHid::MatchesProgram(program), "XBox fingerprint");
+}
+
+static void TestDualShock4()
+{
+	ProgramStruct program{};
+	Check(Parser::Compile(DualShock4Descriptor, sizeof(DualShock4Descriptor), program), "DS4 compiles");
+	Check(program.ReportId == 1, "DS4 input report 1");
+	Check(program.ReportSize == 63, "DS4 report size");
+
+	Check(HasField(program, TargetEnum::Joy1X, 0, 8), "DS4 Joy1X");
+	Check(HasField(program, TargetEnum::Joy1Y, 8, 8), "DS4 Joy1Y");
+	Check(HasField(program, TargetEnum::Joy2X, 16, 8), "DS4 Joy2X");
+	Check(HasField(program, TargetEnum::Joy2Y, 24, 8), "DS4 Joy2Y");
+	Check(HasField(program, TargetEnum::DPad, 32, 4), "DS4 DPad");
+
+	// Rx/Ry are the triggers when Z/Rz are the right stick.
+	Check(HasField(program, TargetEnum::L2, 56, 8), "DS4 L2");
+	Check(HasField(program, TargetEnum::R2, 64, 8), "DS4 R2");
+	Check(Find(program, TargetEnum::L2Digital) == nullptr, "DS4 no digital L2");
+	Check(Find(program, TargetEnum::R2Digital) == nullptr, "DS4 no digital R2");
+
+	const FieldStruct* dPad = Find(program, TargetEnum::DPad);
+	Check(dPad != nullptr && GetHat(*dPad, 0) == 1 && GetHat(*dPad, 8) == 0, "DS4 hat");
+
+	const FieldStruct* l2 = Find(program, TargetEnum::L2);
+	Check(l2 != nullptr && GetUnsigned(*l2, 0) == 0 && GetUnsigned(*l2, UINT8_MAX) == UINT16_MAX, "DS4 trigger range");
+
+	Check(!XBoxControllerHid::MatchesProgram(program), "DS4 not XBox");
+}
+
+static void TestMalformed()
+{
+	ProgramStruct program{};
+
+	// Every truncation must fail or compile, never read past the end.
+	bool truncated = true;
+	for (uint16_t size = 0; size < sizeof(XBoxDescriptor); size++)
+	{
+		uint8_t copy[sizeof(XBoxDescriptor)];
+		memcpy(copy, XBoxDescriptor, size);
+		Parser::Compile(copy, size, program);
+		truncated &= program.Count <= ProgramStruct::MaxFields;
+	}
+	Check(truncated, "Truncated descriptors");
+
+	Check(!Parser::Compile(nullptr, 0, program), "No descriptor");
+}
+
+int main()
+{
+	TestXBox();
+	TestDualShock4();
+	TestMalformed();
+
+	if (Failures > 0)
+	{
+		printf("%u failures.\n", Failures);
+		return 1;
+	}
+
+	printf("All passed.\n");
+	return 0;
+}
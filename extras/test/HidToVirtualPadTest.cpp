@@ -0,0 +1,154 @@
+// HidToVirtualPadTest.cpp
+// Host test for the HID to Virtual Pad mapping, from the report map to the applied Virtual Pad state.
+// Every notification comes with the same report UUID, so the mapping must follow the report map.
+// Build and run from the repository root:
+//	g++ -std=c++11 -Wall -Isrc -Iextras/test/stubs extras/test/HidToVirtualPadTest.cpp -o HidToVirtualPadTest && ./HidToVirtualPadTest
+
+#include <stdio.h>
+#include <string.h>
+
+#include "HidHost/HidToVirtualPad.h"
+
+#include "TestDescriptors.h"
+
+/// <summary>
+/// HID Report characteristic, shared by every controller.
+/// </summary>
+static constexpr uint16_t ReportUuid = 0x2A4D;
+
+static constexpr uint8_t DualShock4ReportSize = 63;
+
+using TestPad = HidToVirtualPad<0>;
+
+static uint16_t Failures = 0;
+
+static void Check(const bool condition, const char* what)
+{
+	if (!condition)
+	{
+		Failures++;
+		printf("FAIL: %s\n", what);
+	}
+}
+
+static void TestXBox()
+{
+	TestPad pad{};
+	pad.OnStateChange(true);
+	pad.OnReportMap(XBoxDescriptor, sizeof(XBoxDescriptor));
+	Check(pad.GetMapType() == HidMapTypeEnum::XBox, "XBox map selected");
+
+	uint8_t report[XBoxControllerHid::DataSize]{};
+	// Sticks centered, right trigger full.
+	report[1] = 0x80;
+	report[3] = 0x80;
+	report[5] = 0x80;
+	report[7] = 0x80;
+	report[10] = XBoxControllerHid::TriggerMax & UINT8_MAX;
+	report[11] = XBoxControllerHid::TriggerMax >> 8;
+	report[12] = (uint8_t)XBoxControllerHid::DPad::Right;
+	report[13] = 1 << (uint8_t)XBoxControllerHid::Buttons1::A;
+	report[14] = 1 << (uint8_t)XBoxControllerHid::Buttons2::Start;
+
+	pad.OnControllerNotify(report, sizeof(report), ReportUuid);
+	Check(pad.Update(), "XBox updated");
+	Check(pad.Connected(), "XBox connected");
+	Check(pad.A() && !pad.B() && pad.Start() && !pad.Select(), "XBox buttons");
+	Check(pad.DPad() == VirtualPad::DPadEnum::Right, "XBox DPad");
+	Check(pad.L2() == 0 && pad.R2() > 0, "XBox triggers");
+	Check(pad.Joy1X() == 0 && pad.Joy1Y() == 0, "XBox sticks centered");
+
+	// Short reports are dropped.
+	pad.OnControllerNotify(report, sizeof(report) - 1, ReportUuid);
+	Check(!pad.Update(), "XBox short report");
+}
+
+static void TestDualShock4()
+{
+	HidReport::ProgramStruct program{};
+	Check(HidReport::Parser::Compile(DualShock4Descriptor, sizeof(DualShock4Descriptor), program), "DS4 compiles");
+
+	// Cached program, restored before the report map is read again.
+	TestPad pad{};
+	pad.OnStateChange(true);
+	pad.OnReportProgram(program);
+	Check(pad.GetMapType() == HidMapTypeEnum::GenericGamepad, "DS4 program selected");
+
+	HidReport::ProgramStruct cached{};
+	Check(pad.GetReportProgram(cached) && cached.Count == program.Count, "DS4 program cached");
+
+	uint8_t report[DualShock4ReportSize]{};
+	// Sticks centered.
+	report[0] = 0x80;
+	report[1] = 0x80;
+	report[2] = 0x80;
+	report[3] = 0x80;
+	// Hat up (0) and button 1.
+	report[4] = 0x10;
+	// Rx, left trigger full.
+	report[7] = UINT8_MAX;
+
+	pad.OnControllerNotify(report, sizeof(report), ReportUuid);
+	Check(pad.Update(), "DS4 updated");
+	Check(pad.Connected(), "DS4 connected");
+	Check(pad.A() && !pad.B() && !pad.Start(), "DS4 buttons");
+	Check(pad.DPad() == VirtualPad::DPadEnum::Up, "DS4 DPad");
+	Check(pad.L2() > 0 && pad.R2() == 0, "DS4 triggers");
+
+	// Hat centered (8) and button 2.
+	report[4] = 0x28;
+	report[7] = 0;
+	pad.OnControllerNotify(report, sizeof(report), ReportUuid);
+	Check(pad.Update(), "DS4 updated again");
+	Check(!pad.A() && pad.B(), "DS4 buttons released");
+	Check(pad.DPad() == VirtualPad::DPadEnum::None, "DS4 DPad centered");
+	Check(pad.L2() == 0, "DS4 trigger released");
+
+	// The same report through the report map.
+	TestPad mapped{};
+	mapped.OnStateChange(true);
+	mapped.OnReportMap(DualShock4Descriptor, sizeof(DualShock4Descriptor));
+	Check(mapped.GetMapType() == HidMapTypeEnum::GenericGamepad, "DS4 map selected");
+	report[4] = 0x10;
+	mapped.OnControllerNotify(report, sizeof(report), ReportUuid);
+	Check(mapped.Update() && mapped.A() && mapped.DPad() == VirtualPad::DPadEnum::Up, "DS4 mapped from report map");
+}
+
+static void TestDisconnect()
+{
+	TestPad pad{};
+	pad.OnStateChange(true);
+	pad.OnReportMap(DualShock4Descriptor, sizeof(DualShock4Descriptor));
+
+	uint8_t report[DualShock4ReportSize]{};
+	report[4] = 0x10;
+	pad.OnControllerNotify(report, sizeof(report), ReportUuid);
+	Check(pad.Update() && pad.Connected(), "Connected before disconnect");
+
+	pad.OnStateChange(false);
+	Check(pad.GetMapType() == HidMapTypeEnum::XBox, "Map reset on disconnect");
+
+	HidReport::ProgramStruct cached{};
+	Check(!pad.GetReportProgram(cached), "Program dropped on disconnect");
+
+	// A report superseding the disconnected state still applies the disconnection first.
+	pad.OnStateChange(true);
+	Check(pad.Update(), "Disconnect updated");
+	Check(!pad.A(), "Disconnect cleared");
+}
+
+int main()
+{
+	TestXBox();
+	TestDualShock4();
+	TestDisconnect();
+
+	if (Failures > 0)
+	{
+		printf("%u failures.\n", Failures);
+		return 1;
+	}
+
+	printf("All passed.\n");
+	return 0;
+}
@@ -0,0 +1,82 @@
+// TestDescriptors.h
+// Real controller report descriptors, shared by the host tests.
+
+#ifndef _TEST_DESCRIPTORS_h
+#define _TEST_DESCRIPTORS_h
+
+#include <stdint.h>
+
+/// <summary>
+/// Xbox Wireless Controller (BLE), as reported by the controller.
+/// Output report 3 (rumble) included, the compiler must skip it.
+/// </summary>
+static const uint8_t XBoxDescriptor[] =
+{
+	0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0x85, 0x01,
+	0x09, 0x01, 0xA1, 0x00, 0x09, 0x30, 0x09, 0x31,
+	0x15, 0x00, 0x27, 0xFF, 0xFF, 0x00, 0x00, 0x95,
+	0x02, 0x75, 0x10, 0x81, 0x02, 0xC0,
+	0x09, 0x01, 0xA1, 0x00, 0x09, 0x32, 0x09, 0x35,
+	0x15, 0x00, 0x27, 0xFF, 0xFF, 0x00, 0x00, 0x95,
+	0x02, 0x75, 0x10, 0x81, 0x02, 0xC0,
+	0x05, 0x02, 0x09, 0xC5, 0x15, 0x00, 0x26, 0xFF,
+	0x03, 0x95, 0x01, 0x75, 0x0A, 0x81, 0x02, 0x15,
+	0x00, 0x25, 0x00, 0x75, 0x06, 0x95, 0x01, 0x81,
+	0x03,
+	0x05, 0x02, 0x09, 0xC4, 0x15, 0x00, 0x26, 0xFF,
+	0x03, 0x95, 0x01, 0x75, 0x0A, 0x81, 0x02, 0x15,
+	0x00, 0x25, 0x00, 0x75, 0x06, 0x95, 0x01, 0x81,
+	0x03,
+	0x05, 0x01, 0x09, 0x39, 0x15, 0x01, 0x25, 0x08,
+	0x35, 0x00, 0x46, 0x3B, 0x01, 0x66, 0x14, 0x00,
+	0x75, 0x04, 0x95, 0x01, 0x81, 0x42, 0x75, 0x04,
+	0x95, 0x01, 0x15, 0x00, 0x25, 0x00, 0x35, 0x00,
+	0x45, 0x00, 0x65, 0x00, 0x81, 0x03,
+	0x05, 0x09, 0x19, 0x01, 0x29, 0x0F, 0x15, 0x00,
+	0x25, 0x01, 0x75, 0x01, 0x95, 0x0F, 0x81, 0x02,
+	0x15, 0x00, 0x25, 0x00, 0x75, 0x01, 0x95, 0x01,
+	0x81, 0x03,
+	0x05, 0x0C, 0x0A, 0xB2, 0x00, 0x15, 0x00, 0x25,
+	0x01, 0x95, 0x01, 0x75, 0x01, 0x81, 0x02, 0x15,
+	0x00, 0x25, 0x00, 0x75, 0x07, 0x95, 0x01, 0x81,
+	0x03,
+	0x05, 0x0F, 0x09, 0x21, 0x85, 0x03, 0xA1, 0x02,
+	0x09, 0x97, 0x15, 0x00, 0x25, 0x01, 0x75, 0x04,
+	0x95, 0x01, 0x91, 0x02, 0x15, 0x00, 0x25, 0x00,
+	0x75, 0x04, 0x95, 0x01, 0x91, 0x03, 0x09, 0x70,
+	0x15, 0x00, 0x25, 0x64, 0x75, 0x08, 0x95, 0x04,
+	0x91, 0x02, 0x09, 0x50, 0x66, 0x01, 0x10, 0x55,
+	0x0E, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08,
+	0x95, 0x01, 0x91, 0x02, 0x09, 0xA7, 0x15, 0x00,
+	0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x01, 0x91,
+	0x02, 0x65, 0x00, 0x55, 0x00, 0x09, 0x7C, 0x15,
+	0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x01,
+	0x91, 0x02, 0xC0,
+	0xC0
+};
+
+/// <summary>
+/// DualShock 4 (USB), input report 1 with the trailing vendor fields.
+/// Z/Rz right stick, Rx/Ry analog triggers and 0-based hat.
+/// </summary>
+static const uint8_t DualShock4Descriptor[] =
+{
+	0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0x85, 0x01,
+	0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35,
+	0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95,
+	0x04, 0x81, 0x02,
+	0x09, 0x39, 0x15, 0x00, 0x25, 0x07, 0x35, 0x00,
+	0x46, 0x3B, 0x01, 0x65, 0x14, 0x75, 0x04, 0x95,
+	0x01, 0x81, 0x42, 0x65, 0x00,
+	0x05, 0x09, 0x19, 0x01, 0x29, 0x0E, 0x15, 0x00,
+	0x25, 0x01, 0x75, 0x01, 0x95, 0x0E, 0x81, 0x02,
+	0x06, 0x00, 0xFF, 0x09, 0x20, 0x75, 0x06, 0x95,
+	0x01, 0x15, 0x00, 0x25, 0x7F, 0x81, 0x02,
+	0x05, 0x01, 0x09, 0x33, 0x09, 0x34, 0x15, 0x00,
+	0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x02, 0x81,
+	0x02,
+	0x06, 0x00, 0xFF, 0x09, 0x21, 0x95, 0x36, 0x81,
+	0x02,
+	0xC0
+};
+#endif
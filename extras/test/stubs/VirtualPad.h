@@ -0,0 +1,87 @@
+// VirtualPad.h
+// Host stand-in for the VirtualPad library, records the last state set by the writer.
+
+#ifndef _VIRTUAL_PAD_STUB_h
+#define _VIRTUAL_PAD_STUB_h
+
+#include <stdint.h>
+
+namespace VirtualPad
+{
+	enum class DPadEnum : uint8_t
+	{
+		None,
+		Up,
+		UpRight,
+		Right,
+		DownRight,
+		Down,
+		DownLeft,
+		Left,
+		UpLeft
+	};
+
+	template<uint32_t configurationCode>
+	class AnalogVirtualPad
+	{
+	protected:
+		DPadEnum dPad = DPadEnum::None;
+
+	private:
+		int16_t joy1X = 0, joy1Y = 0, joy2X = 0, joy2Y = 0;
+		uint16_t l2 = 0, r2 = 0;
+		bool a = false, b = false, x = false, y = false;
+		bool l1 = false, r1 = false, l3 = false, r3 = false;
+		bool start = false, select = false, home = false, share = false;
+		bool connected = false;
+
+	public:
+		void Clear()
+		{
+			*this = AnalogVirtualPad();
+		}
+
+		const bool Connected() const { return connected; }
+		void SetConnected(const bool value) { connected = value; }
+
+		void SetJoy1(const int16_t valueX, const int16_t valueY) { joy1X = valueX; joy1Y = valueY; }
+		void SetJoy2(const int16_t valueX, const int16_t valueY) { joy2X = valueX; joy2Y = valueY; }
+		void SetL2(const uint16_t value) { l2 = value; }
+		void SetR2(const uint16_t value) { r2 = value; }
+
+		void SetA(const bool value) { a = value; }
+		void SetB(const bool value) { b = value; }
+		void SetX(const bool value) { x = value; }
+		void SetY(const bool value) { y = value; }
+		void SetL1(const bool value) { l1 = value; }
+		void SetR1(const bool value) { r1 = value; }
+		void SetL3(const bool value) { l3 = value; }
+		void SetR3(const bool value) { r3 = value; }
+		void SetStart(const bool value) { start = value; }
+		void SetSelect(const bool value) { select = value; }
+		void SetHome(const bool value) { home = value; }
+		void SetShare(const bool value) { share = value; }
+
+		const DPadEnum DPad() const { return dPad; }
+		const int16_t Joy1X() const { return joy1X; }
+		const int16_t Joy1Y() const { return joy1Y; }
+		const int16_t Joy2X() const { return joy2X; }
+		const int16_t Joy2Y() const { return joy2Y; }
+		const uint16_t L2() const { return l2; }
+		const uint16_t R2() const { return r2; }
+
+		const bool A() const { return a; }
+		const bool B() const { return b; }
+		const bool X() const { return x; }
+		const bool Y() const { return y; }
+		const bool L1() const { return l1; }
+		const bool R1() const { return r1; }
+		const bool L3() const { return l3; }
+		const bool R3() const { return r3; }
+		const bool Start() const { return start; }
+		const bool Select() const { return select; }
+		const bool Home() const { return home; }
+		const bool Share() const { return share; }
+	};
+}
+#endif
@@ -0,0 +1,98 @@
+// AnalogCurve.h
+
+#ifndef _ANALOG_CURVE_h
+#define _ANALOG_CURVE_h
+
+#include <stdint.h>
+
+/// <summary>
+/// Analog response curves, as 17 point lookup tables in Q15 [0 ; 32767],
+/// linearly interpolated over 16 segments.
+/// </summary>
+namespace AnalogCurve
+{
+	enum class CurveEnum : uint8_t
+	{
+		Linear,
+		Quadratic,
+		Cubic
+	};
+
+	static constexpr uint16_t Max = INT16_MAX;
+	static constexpr uint8_t SegmentBits = 11;
+	static constexpr uint8_t PointCount = (1 << (15 - SegmentBits)) + 1;
+
+	struct Curve
+	{
+		static constexpr uint16_t GetX(const uint8_t point)
+		{
+			return ((uint32_t)point << SegmentBits) > Max ? Max : (uint16_t)((uint32_t)point << SegmentBits);
+		}
+
+		static constexpr uint16_t Quadratic(const uint8_t point)
+		{
+			return ((uint32_t)GetX(point) * GetX(point)) / Max;
+		}
+
+		static constexpr uint16_t Cubic(const uint8_t point)
+		{
+			return ((uint64_t)GetX(point) * GetX(point) * GetX(point)) / ((uint32_t)Max * Max);
+		}
+	};
+
+	/// <summary>
+	/// Curve lookup table, nullptr for linear.
+	/// </summary>
+	inline const uint16_t* GetTable(const CurveEnum curve)
+	{
+		static constexpr uint16_t QuadraticTable[PointCount] =
+		{
+			Curve::Quadratic(0), Curve::Quadratic(1), Curve::Quadratic(2), Curve::Quadratic(3),
+			Curve::Quadratic(4), Curve::Quadratic(5), Curve::Quadratic(6), Curve::Quadratic(7),
+			Curve::Quadratic(8), Curve::Quadratic(9), Curve::Quadratic(10), Curve::Quadratic(11),
+			Curve::Quadratic(12), Curve::Quadratic(13), Curve::Quadratic(14), Curve::Quadratic(15),
+			Curve::Quadratic(16)
+		};
+
+		static constexpr uint16_t CubicTable[PointCount] =
+		{
+			Curve::Cubic(0), Curve::Cubic(1), Curve::Cubic(2), Curve::Cubic(3),
+			Curve::Cubic(4), Curve::Cubic(5), Curve::Cubic(6), Curve::Cubic(7),
+			Curve::Cubic(8), Curve::Cubic(9), Curve::Cubic(10), Curve::Cubic(11),
+			Curve::Cubic(12), Curve::Cubic(13), Curve::Cubic(14), Curve::Cubic(15),
+			Curve::Cubic(16)
+		};
+
+		switch (curve)
+		{
+		case CurveEnum::Quadratic:
+			return QuadraticTable;
+		case CurveEnum::Cubic:
+			return CubicTable;
+		case CurveEnum::Linear:
+		default:
+			return nullptr;
+		}
+	}
+
+	/// <summary>
+	/// Interpolated curve lookup.
+	/// </summary>
+	/// <param name="table">Curve table, nullptr for linear.</param>
+	/// <param name="value">Q15 [0 ; 32767]</param>
+	inline const uint16_t Apply(const uint16_t* table, const uint16_t value)
+	{
+		if (table == nullptr)
+		{
+			return value;
+		}
+
+		const uint8_t segment = value >> SegmentBits;
+		const uint16_t fraction = value & ((1 << SegmentBits) - 1);
+		const int32_t start = table[segment];
+		const int32_t delta = (int32_t)table[segment + 1] - start;
+
+		return start + ((delta * fraction) >> SegmentBits);
+	}
+}
+#endif
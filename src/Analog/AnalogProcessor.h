@@ -0,0 +1,245 @@
+// AnalogProcessor.h
+
+#ifndef _ANALOG_PROCESSOR_h
+#define _ANALOG_PROCESSOR_h
+
+#include <stdint.h>
+
+#include "AnalogCurve.h"
+#include "AxisKernels.h"
+
+namespace AnalogProcessor
+{
+	enum class DeadzoneEnum : uint8_t
+	{
+		None,
+
+		/// <summary>
+		/// Deadzone on the stick magnitude, keeps the direction.
+		/// </summary>
+		Radial,
+
+		/// <summary>
+		/// Deadzone on each axis, snaps to the axes near the center.
+		/// </summary>
+		Axial
+	};
+
+	/// <summary>
+	/// Stick response, in Q15 [0 ; 32767] magnitude units.
+	/// </summary>
+	struct StickProfileStruct
+	{
+		DeadzoneEnum Mode = DeadzoneEnum::Radial;
+
+		/// <summary>
+		/// Input below this is zero.
+		/// </summary>
+		uint16_t Deadzone = 0;
+
+		/// <summary>
+		/// Input at or over this is full scale, compensates sticks that don't reach the edge.
+		/// </summary>
+		uint16_t Outer = AnalogCurve::Max;
+
+		/// <summary>
+		/// Output starts from here, compensates the deadzone of the game.
+		/// </summary>
+		uint16_t AntiDeadzone = 0;
+
+		AnalogCurve::CurveEnum Curve = AnalogCurve::CurveEnum::Linear;
+	};
+
+	/// <summary>
+	/// Trigger response, in raw [0 ; UINT16_MAX] units.
+	/// </summary>
+	struct TriggerProfileStruct
+	{
+		uint16_t Deadzone = 0;
+		uint16_t Outer = UINT16_MAX;
+	};
+
+	/// <summary>
+	/// Integer square root, for 32 bit magnitudes.
+	/// </summary>
+	inline const uint16_t SquareRoot(uint32_t value)
+	{
+		uint32_t root = 0;
+		uint32_t bit = (uint32_t)1 << 30;
+
+		while (bit > value)
+		{
+			bit >>= 2;
+		}
+
+		while (bit != 0)
+		{
+			if (value >= root + bit)
+			{
+				value -= root + bit;
+				root = (root >> 1) + bit;
+			}
+			else
+			{
+				root >>= 1;
+			}
+			bit >>= 2;
+		}
+
+		return root;
+	}
+
+	/// <summary>
+	/// Fixed-point stick stage: deadzone, outer clamp, response curve and anti-deadzone.
+	/// Profile divisions are precomputed on SetProfile, processing costs one square root and one divide for radial mode.
+	/// </summary>
+	class Stick
+	{
+	private:
+		static constexpr uint8_t ScaleShift = 16;
+
+	private:
+		const uint16_t* CurveTable = nullptr;
+		uint32_t InputScale = (uint32_t)1 << ScaleShift;
+		uint16_t Deadzone = 0;
+		uint16_t Outer = AnalogCurve::Max;
+		uint16_t AntiDeadzone = 0;
+		uint16_t OutputRange = AnalogCurve::Max;
+		DeadzoneEnum Mode = DeadzoneEnum::None;
+
+	public:
+		Stick() {}
+
+		Stick(const StickProfileStruct& profile)
+		{
+			SetProfile(profile);
+		}
+
+		void SetProfile(const StickProfileStruct& profile)
+		{
+			Outer = profile.Outer > 0 && profile.Outer <= AnalogCurve::Max ? profile.Outer : AnalogCurve::Max;
+			Deadzone = profile.Deadzone < Outer ? profile.Deadzone : Outer - 1;
+			AntiDeadzone = profile.AntiDeadzone < AnalogCurve::Max ? profile.AntiDeadzone : AnalogCurve::Max - 1;
+			OutputRange = AnalogCurve::Max - AntiDeadzone;
+			InputScale = ((uint32_t)AnalogCurve::Max << ScaleShift) / (Outer - Deadzone);
+			CurveTable = AnalogCurve::GetTable(profile.Curve);
+			Mode = profile.Mode;
+		}
+
+		void Process(int16_t& x, int16_t& y) const
+		{
+			switch (Mode)
+			{
+			case DeadzoneEnum::Radial:
+				ProcessRadial(x, y);
+				break;
+			case DeadzoneEnum::Axial:
+				x = ProcessAxis(x);
+				y = ProcessAxis(y);
+				break;
+			case DeadzoneEnum::None:
+			default:
+				break;
+			}
+		}
+
+	private:
+		/// <summary>
+		/// Magnitude response, Q15.
+		/// </summary>
+		const uint16_t GetResponse(const uint16_t magnitude) const
+		{
+			if (magnitude <= Deadzone)
+			{
+				return 0;
+			}
+			else if (magnitude >= Outer)
+			{
+				return AnalogCurve::Max;
+			}
+
+			const uint16_t normalized = ((uint32_t)(magnitude - Deadzone) * InputScale) >> ScaleShift;
+			const uint16_t curved = AnalogCurve::Apply(CurveTable, normalized > AnalogCurve::Max ? AnalogCurve::Max : normalized);
+
+			return AntiDeadzone + (((uint32_t)curved * OutputRange) >> 15);
+		}
+
+		const int16_t ProcessAxis(const int16_t value) const
+		{
+			const uint16_t magnitude = value < 0 ? (value == INT16_MIN ? AnalogCurve::Max : -value) : value;
+			const uint16_t response = GetResponse(magnitude);
+
+			return value < 0 ? -(int16_t)response : (int16_t)response;
+		}
+
+		void ProcessRadial(int16_t& x, int16_t& y) const
+		{
+			const int32_t x32 = x;
+			const int32_t y32 = y;
+			const uint32_t magnitude = SquareRoot(AxisKernels::MagnitudeSquared(AxisKernels::Pack(x, y)));
+
+			if (magnitude <= Deadzone)
+			{
+				x = 0;
+				y = 0;
+				return;
+			}
+
+			// Diagonals of square gated sticks go over the unit circle.
+			const uint16_t response = GetResponse(magnitude > AnalogCurve::Max ? AnalogCurve::Max : magnitude);
+
+			x = Clamp((x32 * response) / (int32_t)magnitude);
+			y = Clamp((y32 * response) / (int32_t)magnitude);
+		}
+
+		static const int16_t Clamp(const int32_t value)
+		{
+			return value > INT16_MAX ? INT16_MAX : (value < -INT16_MAX ? -INT16_MAX : value);
+		}
+	};
+
+	/// <summary>
+	/// Trigger stage: deadzone and rescale to full range, with a precomputed reciprocal.
+	/// </summary>
+	class Trigger
+	{
+	private:
+		static constexpr uint8_t ScaleShift = 16;
+
+	private:
+		uint32_t Scale = (uint32_t)1 << ScaleShift;
+		uint16_t Deadzone = 0;
+		uint16_t Outer = UINT16_MAX;
+
+	public:
+		Trigger() {}
+
+		Trigger(const TriggerProfileStruct& profile)
+		{
+			SetProfile(profile);
+		}
+
+		void SetProfile(const TriggerProfileStruct& profile)
+		{
+			Outer = profile.Outer > 0 ? profile.Outer : UINT16_MAX;
+			Deadzone = profile.Deadzone < Outer ? profile.Deadzone : Outer - 1;
+			Scale = ((uint32_t)UINT16_MAX << ScaleShift) / (Outer - Deadzone);
+		}
+
+		const uint16_t Process(const uint16_t value) const
+		{
+			if (value <= Deadzone)
+			{
+				return 0;
+			}
+			else if (value >= Outer)
+			{
+				return UINT16_MAX;
+			}
+
+			// Below Outer, the product stays under UINT16_MAX << ScaleShift.
+			return ((uint32_t)(value - Deadzone) * Scale) >> ScaleShift;
+		}
+	};
+}
+#endif
@@ -0,0 +1,205 @@
+// AxisKernels.h
+
+#ifndef _AXIS_KERNELS_h
+#define _AXIS_KERNELS_h
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_NRF52) && defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include <nrf.h>
+#define AXIS_KERNELS_SIMD
+#endif
+
+/// <summary>
+/// Axis pair kernels, two 16 bit lanes packed in a 32 bit word (low, high).
+/// Uses the Cortex-M4 DSP extension (SIMD16) when available.
+/// The scalar kernels are always available under AxisKernels::Scalar and give the same results,
+/// extras/test checks them against a reference on the host, examples/AxisKernelsTester checks SIMD against them on target.
+/// </summary>
+namespace AxisKernels
+{
+	/// <summary>
+	/// Unaligned little endian pair read, e.g. straight from a report.
+	/// </summary>
+	inline const uint32_t Load(const uint8_t* data)
+	{
+		uint32_t pair;
+		memcpy(&pair, data, sizeof(pair));
+
+		return pair;
+	}
+
+	inline const int16_t Low(const uint32_t pair)
+	{
+		return (int16_t)(pair & UINT16_MAX);
+	}
+
+	inline const int16_t High(const uint32_t pair)
+	{
+		return (int16_t)(pair >> 16);
+	}
+
+	/// <summary>
+	/// Offset binary to two's complement (and back), both lanes.
+	/// </summary>
+	inline const uint32_t FlipBias(const uint32_t pair)
+	{
+		return pair ^ 0x80008000;
+	}
+
+	/// <summary>
+	/// One's complement of the high lane, i.e. -1 - y, inverts an axis without overflow.
+	/// </summary>
+	inline const uint32_t InvertHigh(const uint32_t pair)
+	{
+		return pair ^ 0xFFFF0000;
+	}
+
+	/// <summary>
+	/// Portable kernels, one lane at a time.
+	/// </summary>
+	namespace Scalar
+	{
+		inline const int16_t Saturate(const int32_t value)
+		{
+			return value > INT16_MAX ? INT16_MAX : (value < INT16_MIN ? INT16_MIN : value);
+		}
+
+		inline const uint16_t SaturateUnsigned(const int32_t value)
+		{
+			return value > UINT16_MAX ? UINT16_MAX : (value < 0 ? 0 : value);
+		}
+
+		inline const uint32_t Pack(const int16_t low, const int16_t high)
+		{
+			return (uint32_t)(uint16_t)low | ((uint32_t)(uint16_t)high << 16);
+		}
+
+		/// <summary>
+		/// Saturating negate, both lanes.
+		/// </summary>
+		inline const uint32_t Negate(const uint32_t pair)
+		{
+			return Pack(Saturate(-(int32_t)Low(pair)), Saturate(-(int32_t)High(pair)));
+		}
+
+		/// <summary>
+		/// x * x + y * y, fits unsigned 32 bit for any pair.
+		/// </summary>
+		inline const uint32_t MagnitudeSquared(const uint32_t pair)
+		{
+			const int32_t low = Low(pair);
+			const int32_t high = High(pair);
+
+			return (uint32_t)(low * low) + (uint32_t)(high * high);
+		}
+
+		/// <summary>
+		/// Saturating fixed-point scale, both lanes: (v * scale) >> Shift, clamped to int16_t.
+		/// </summary>
+		template<uint8_t Shift>
+		inline const uint32_t ScaleSigned(const uint32_t pair, const int16_t scale)
+		{
+			return Pack(Saturate(((int32_t)Low(pair) * scale) >> Shift),
+				Saturate(((int32_t)High(pair) * scale) >> Shift));
+		}
+
+		/// <summary>
+		/// Saturating fixed-point scale of non-negative lanes below 32768: (v * scale) >> Shift, clamped to uint16_t.
+		/// Negative lanes give 0.
+		/// </summary>
+		template<uint8_t Shift>
+		inline const uint32_t ScaleUnsigned(const uint32_t pair, const int16_t scale)
+		{
+			return (uint32_t)SaturateUnsigned(((int32_t)Low(pair) * scale) >> Shift)
+				| ((uint32_t)SaturateUnsigned(((int32_t)High(pair) * scale) >> Shift) << 16);
+		}
+
+		inline const int16_t LaneDeadzone(const int16_t value, const int16_t deadzone)
+		{
+			return value > deadzone ? value - deadzone : (value < -deadzone ? value + deadzone : 0);
+		}
+
+		/// <summary>
+		/// Axial deadzone, both lanes: |v| <= deadzone is 0, otherwise moved towards 0 by deadzone.
+		/// </summary>
+		/// <param name="deadzone">[0 ; INT16_MAX]</param>
+		inline const uint32_t Deadzone(const uint32_t pair, const int16_t deadzone)
+		{
+			return Pack(LaneDeadzone(Low(pair), deadzone), LaneDeadzone(High(pair), deadzone));
+		}
+	}
+
+#if defined(AXIS_KERNELS_SIMD)
+	/// <summary>
+	/// Cortex-M4 DSP kernels, both lanes at once.
+	/// No kernel depends on the GE flags, so the compiler is free to schedule the intrinsics.
+	/// </summary>
+	namespace Simd
+	{
+		inline const uint32_t Pack(const int16_t low, const int16_t high)
+		{
+			return __PKHBT((uint32_t)(uint16_t)low, (uint32_t)(uint16_t)high, 16);
+		}
+
+		inline const uint32_t Negate(const uint32_t pair)
+		{
+			return __QSUB16(0, pair);
+		}
+
+		inline const uint32_t MagnitudeSquared(const uint32_t pair)
+		{
+			// Only the (-32768, -32768) pair overflows the signed result, the bits are still right unsigned.
+			return (uint32_t)__SMUAD(pair, pair);
+		}
+
+		template<uint8_t Shift>
+		inline const uint32_t ScaleSigned(const uint32_t pair, const int16_t scale)
+		{
+			const int32_t low = __SMUAD(pair, (uint32_t)(uint16_t)scale) >> Shift;
+			const int32_t high = __SMUAD(pair, (uint32_t)(uint16_t)scale << 16) >> Shift;
+
+			return __PKHBT((uint32_t)__SSAT(low, 16) & UINT16_MAX, (uint32_t)__SSAT(high, 16), 16);
+		}
+
+		template<uint8_t Shift>
+		inline const uint32_t ScaleUnsigned(const uint32_t pair, const int16_t scale)
+		{
+			const int32_t low = __SMUAD(pair, (uint32_t)(uint16_t)scale) >> Shift;
+			const int32_t high = __SMUAD(pair, (uint32_t)(uint16_t)scale << 16) >> Shift;
+
+			return __PKHBT(__USAT(low, 16), __USAT(high, 16), 16);
+		}
+
+		inline const uint32_t Deadzone(const uint32_t pair, const int16_t deadzone)
+		{
+			const uint32_t deadzones = Pack(deadzone, deadzone);
+
+			// max(v - dz, 0), unsigned saturation to 15 bits clamps negative lanes to 0.
+			const uint32_t above = __USAT16(__QSUB16(pair, deadzones), 15);
+
+			// min(v + dz, 0), i.e. v + dz - max(v + dz, 0).
+			const uint32_t shifted = __QADD16(pair, deadzones);
+			const uint32_t below = __QSUB16(shifted, __USAT16(shifted, 15));
+
+			return __QADD16(above, below);
+		}
+	}
+
+	using Simd::Pack;
+	using Simd::Negate;
+	using Simd::MagnitudeSquared;
+	using Simd::ScaleSigned;
+	using Simd::ScaleUnsigned;
+	using Simd::Deadzone;
+#else
+	using Scalar::Pack;
+	using Scalar::Negate;
+	using Scalar::MagnitudeSquared;
+	using Scalar::ScaleSigned;
+	using Scalar::ScaleUnsigned;
+	using Scalar::Deadzone;
+#endif
+}
+#endif
@@ -7,56 +7,330 @@
 #include <bluefruit.h>
 
 #include "BleConfig.h"
+#include "IHidListener.h"
+#include "BlePeerCache.h"
 
 #include "../Framework/RetroBleDevice.h"
 
-class IHidListener
+/// <summary>
+/// Granted link parameters of a controller connection.
+/// </summary>
+struct BleLinkStruct
 {
-public:
-	virtual void OnControllerNotify(uint8_t* data, const uint16_t size, const uint16_t uuid) {}
-	virtual void OnStateChange(const bool connected) {}
+	/// <summary>
+	/// Connection interval, in units of 1.25 ms.
+	/// </summary>
+	uint16_t Interval = 0;
+	uint16_t SlaveLatency = 0;
+
+	/// <summary>
+	/// Link layer payload, in bytes.
+	/// </summary>
+	uint16_t DataLength = 0;
+
+	/// <summary>
+	/// BLE_GAP_PHY_*
+	/// </summary>
+	uint8_t Phy = 0;
+};
+
+/// <summary>
+/// Reconnect timings, in milliseconds.
+/// </summary>
+struct BleReconnectStatsStruct
+{
+	/// <summary>
+	/// Connections that reached their first report.
+	/// </summary>
+	uint32_t Count = 0;
+
+	/// <summary>
+	/// From the scan start (boot or disconnect) to the first report, of the last connection.
+	/// </summary>
+	uint32_t ScanToReport = 0;
+
+	/// <summary>
+	/// From connection to the first report, of the last connection.
+	/// </summary>
+	uint32_t ConnectToReport = 0;
+
+	uint32_t ConnectToReportMax = 0;
+};
+
+/// <summary>
+/// Link negotiation steps, run one at a time after connecting.
+/// </summary>
+enum class BleLinkStepEnum : uint8_t
+{
+	Interval,
+	Phy,
+	DataLength,
+	Done
+};
+
+/// <summary>
+/// Controller connection slot, bound to its own listener.
+/// </summary>
+struct BleCentralSlot
+{
+	BLEClientService Service{ UUID16_SVC_HUMAN_INTERFACE_DEVICE };
+	BLEClientCharacteristic CharaReport{ UUID16_CHR_REPORT };
+	BLEClientCharacteristic CharaReportMap{ UUID16_CHR_REPORT_MAP };
+
+	IHidListener* HidListener = nullptr;
+
+	/// <summary>
+	/// Last peer in this slot, kept after disconnect so it reconnects to the same slot.
+	/// </summary>
+	ble_gap_addr_t Address{};
+
+	BleLinkStruct Link{};
+	uint32_t ConnectTimestamp = 0;
+
+	uint16_t Handle = BLE_CONN_HANDLE_INVALID;
+	BleLinkStepEnum LinkStep = BleLinkStepEnum::Done;
+	bool Bound = false;
+	bool Reported = false;
+
+	const bool Connected() const
+	{
+		return Handle != BLE_CONN_HANDLE_INVALID;
+	}
 };
 
+/// <summary>
+/// HID host for up to SlotCount concurrent controllers.
+/// Each connection is bound to a slot (player), a returning controller gets its previous slot if it's free.
+/// After connecting, the link is negotiated towards the fastest interval, no slave latency, 2M PHY and the longest data length.
+/// The controller may refuse any of them, the link keeps whatever was granted.
+/// Forward the BLE events to OnBleEvent for the negotiation to progress.
+/// After boot or a disconnect, the cached (bonded) controllers are whitelist scanned at full duty for a few seconds,
+/// before falling back to the open scan for new controllers. The reconnect window needs the BLE events as well.
+/// The whitelist holds identity addresses and the SoftDevice gets the peer IRKs, so controllers advertising with a
+/// resolvable private address are recognized too.
+/// Known controllers restore encryption from the bond keys before discovery, new ones pair after it.
+/// Both block the connection callback in sequence.
+/// The open scan backs off exponentially to a low duty background scan, Wake() kicks it back to the fast start.
+/// Scan and whitelist state is only touched from the Bluefruit callbacks, Wake() defers to them.
+/// </summary>
+/// <typeparam name="SlotCount">Concurrent connections, sized at compile time.</typeparam>
+template<uint8_t SlotCount = 1>
 class BleCentral
 {
 private:
-	uint16_t Handle = 0;
+	static_assert(SlotCount > 0 && SlotCount <= BLE_CENTRAL_MAX_CONN, "Invalid central slot count.");
+	static_assert(RetroBle::BleConfig::CentralScan::WhitelistSize <= BLE_GAP_DEVICE_IDENTITIES_MAX_COUNT,
+		"Whitelist larger than the device identity list.");
+	static_assert(((RetroBle::BleConfig::CentralScan::BackoffStartMillis << (RetroBle::BleConfig::CentralScan::BackoffStages - 1)) / 10) <= UINT16_MAX,
+		"Backoff stage too long for the scan timeout.");
+	static_assert(((uint32_t)RetroBle::BleConfig::CentralScan::Interval << RetroBle::BleConfig::CentralScan::BackoffStages) <= BLE_GAP_SCAN_INTERVAL_MAX,
+		"Background scan interval too long.");
 
 private:
-	BLEClientCharacteristic CharaReport;
-	BLEClientCharacteristic CharaReportMap;
+	BleCentralSlot Slots[SlotCount]{};
 
-	BLEClientService XBoxService;
+private:
+	BlePeerCache PeerCache{};
+	BlePeerEntryStruct PeerEntry{};
+	uint8_t ReportMap[RetroBle::BleConfig::REPORT_MAP_MAX_SIZE]{};
 
 private:
-	IHidListener* HidListener;
+	ble_gap_id_key_t Whitelist[RetroBle::BleConfig::CentralScan::WhitelistSize]{};
+	BleReconnectStatsStruct ReconnectStats{};
+	uint32_t ReconnectStart = 0;
+	uint8_t WhitelistCount = 0;
+	bool Reconnecting = false;
+	bool EventsForwarded = false;
+	volatile bool WakePending = false;
+
+private:
+	uint32_t ScanRadioMillis = 0;
+	uint32_t ScanStart = 0;
+	uint16_t ScanInterval = 0;
+	uint16_t ScanWindow = 0;
+	uint8_t ScanStage = 0;
 
 public:
+	/// <summary>
+	/// One listener per slot, in player order.
+	/// </summary>
+	template<typename ListenerType>
+	BleCentral(ListenerType(&hidListeners)[SlotCount])
+	{
+		for (uint8_t i = 0; i < SlotCount; i++)
+		{
+			Slots[i].HidListener = &hidListeners[i];
+		}
+	}
+
+	/// <summary>
+	/// Single listener on the first slot.
+	/// </summary>
 	BleCentral(IHidListener* hidListener)
-		: CharaReport(UUID16_CHR_REPORT)
-		, CharaReportMap(UUID16_CHR_REPORT_MAP)
-		, XBoxService(UUID16_SVC_HUMAN_INTERFACE_DEVICE)
-		, HidListener(hidListener)
 	{
+		Slots[0].HidListener = hidListener;
 	}
 
 	void Setup(void (*onConnect)(const uint16_t conn_hdl),
 		void (*onDisconnect)(const uint16_t conn_hdl, const uint8_t reason),
 		void (*onScanCallback)(ble_gap_evt_adv_report_t* report),
 		void (*onConnectionSecured)(uint16_t conn_handle),
-		void (*onReportNotify)(BLEClientCharacteristic* chr, uint8_t* data, uint16_t len))
+		void (*onReportNotify)(BLEClientCharacteristic* chr, uint8_t* data, uint16_t len),
+		void (*onBleEvent)(ble_evt_t* bleEvent) = nullptr)
+	{
+		for (uint8_t i = 0; i < SlotCount; i++)
+		{
+			// Characteristics attach to the last service started.
+			Slots[i].Service.begin();
+
+			Slots[i].CharaReport.setNotifyCallback(onReportNotify);
+			Slots[i].CharaReport.begin();
+			Slots[i].CharaReportMap.begin();
+		}
+
+		SetupBle(onConnect, onDisconnect, onScanCallback, onConnectionSecured, onBleEvent);
+
+		PeerCache.Setup();
+
+		StartReconnect();
+	}
+
+	static constexpr uint8_t GetSlotCount()
+	{
+		return SlotCount;
+	}
+
+	const bool IsConnected(const uint8_t slot) const
+	{
+		return slot < SlotCount && Slots[slot].Connected();
+	}
+
+	/// <summary>
+	/// Link parameters granted so far.
+	/// </summary>
+	/// <returns>False if the slot isn't connected.</returns>
+	const bool GetLink(const uint8_t slot, BleLinkStruct& link) const
+	{
+		if (!IsConnected(slot))
+		{
+			return false;
+		}
+
+		link = Slots[slot].Link;
+
+		return true;
+	}
+
+	void GetReconnectStats(BleReconnectStatsStruct& stats) const
+	{
+		stats = ReconnectStats;
+	}
+
+	/// <summary>
+	/// Back to the fast scan, e.g. on a request from the host.
+	/// Safe from any task, the reconnect starts from the Bluefruit callback task,
+	/// serialized with the connection and scan callbacks.
+	/// </summary>
+	void Wake()
+	{
+		if (!WakePending)
+		{
+			WakePending = true;
+			ada_callback(NULL, 0, OnWakeCallback, (uint32_t)this);
+		}
+	}
+
+	/// <summary>
+	/// Current scan duty, in permille, 0 when not scanning.
+	/// </summary>
+	const uint16_t GetScanDuty() const
+	{
+		return ScanInterval > 0 ? ((uint32_t)ScanWindow * 1000) / ScanInterval : 0;
+	}
+
+	/// <summary>
+	/// Accumulated scan radio time, in milliseconds.
+	/// </summary>
+	const uint32_t GetScanRadioMillis() const
 	{
-		XBoxService.begin();
+		return ScanRadioMillis + GetStageRadioMillis(millis());
+	}
 
-		CharaReport.setNotifyCallback(onReportNotify);
-		CharaReport.begin();
-		CharaReportMap.begin();
+	/// <summary>
+	/// BLE event callback context, tracks the link procedure results and the scan timeout.
+	/// </summary>
+	void OnBleEvent(ble_evt_t* bleEvent)
+	{
+		const ble_gap_evt_t& gapEvent = bleEvent->evt.gap_evt;
+		BleCentralSlot* slot;
 
-		SetupBle(onConnect, onDisconnect, onScanCallback, onConnectionSecured);
+		switch (bleEvent->header.evt_id)
+		{
+		case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+			slot = FindSlot(gapEvent.conn_handle);
+			if (slot != nullptr)
+			{
+				slot->Link.Interval = gapEvent.params.conn_param_update.conn_params.max_conn_interval;
+				slot->Link.SlaveLatency = gapEvent.params.conn_param_update.conn_params.slave_latency;
+				if (slot->LinkStep == BleLinkStepEnum::Interval)
+				{
+					NegotiateLink(*slot, BleLinkStepEnum::Phy);
+				}
+			}
+			break;
+		case BLE_GAP_EVT_PHY_UPDATE:
+			slot = FindSlot(gapEvent.conn_handle);
+			if (slot != nullptr)
+			{
+				if (gapEvent.params.phy_update.status == BLE_HCI_STATUS_CODE_SUCCESS)
+				{
+					slot->Link.Phy = gapEvent.params.phy_update.tx_phy;
+				}
+				if (slot->LinkStep == BleLinkStepEnum::Phy)
+				{
+					NegotiateLink(*slot, BleLinkStepEnum::DataLength);
+				}
+			}
+			break;
+		case BLE_GAP_EVT_DATA_LENGTH_UPDATE:
+			slot = FindSlot(gapEvent.conn_handle);
+			if (slot != nullptr)
+			{
+				slot->Link.DataLength = gapEvent.params.data_length_update.effective_params.max_tx_octets;
+				if (slot->LinkStep == BleLinkStepEnum::DataLength)
+				{
+					NegotiateLink(*slot, BleLinkStepEnum::Done);
+				}
+			}
+			break;
+		case BLE_GAP_EVT_TIMEOUT:
+			if (gapEvent.params.timeout.src == BLE_GAP_TIMEOUT_SRC_SCAN)
+			{
+				if (Reconnecting)
+				{
+					// Reconnect window is over.
+					Reconnecting = false;
+				}
+				else if (ScanStage < RetroBle::BleConfig::CentralScan::BackoffStages)
+				{
+					ScanStage++;
+				}
+				StartScan();
+			}
+			break;
+		default:
+			break;
+		}
 	}
 
 	void OnConnectionSecured(uint16_t conn_hdl)
 	{
+		BleCentralSlot* slot = FindSlot(conn_hdl);
+		if (slot == nullptr)
+		{
+			return;
+		}
+
 		BLEConnection* conn = Bluefruit.Connection(conn_hdl);
 
 		if (!conn->secured())
@@ -68,9 +342,20 @@ public:
 			// encrypted
 			conn->requestPairing();
 		}
+		else if (EnableCached(*slot))
+		{
+			if (slot->HidListener != nullptr)
+			{
+				slot->HidListener->OnStateChange(true);
+			}
+#if defined(DEBUG)
+			Serial.print(F("Controller connected from cache on slot "));
+			Serial.println(GetSlotIndex(slot));
+#endif
+		}
 		else
 		{
-			if (!CharaReportMap.discover())
+			if (!slot->CharaReportMap.discover())
 			{
 				// Measurement chr is mandatory, if it is not found (valid), then disconnect
 #if defined(DEBUG)
@@ -80,7 +365,7 @@ public:
 				return;
 			}
 
-			if (!CharaReport.discover())
+			if (!slot->CharaReport.discover())
 			{
 #if defined(DEBUG)
 				// Measurement chr is mandatory, if it is not found (valid), then disconnect
@@ -90,14 +375,19 @@ public:
 				return;
 			}
 
-			if (CharaReport.enableNotify())
+			ReadReportMap(*slot);
+
+			if (slot->CharaReport.enableNotify())
 			{
-				if (HidListener != nullptr)
+				SaveCache(*slot);
+
+				if (slot->HidListener != nullptr)
 				{
-					HidListener->OnStateChange(true);
+					slot->HidListener->OnStateChange(true);
 				}
 #if defined(DEBUG)
-				Serial.println(F("Controller connected"));
+				Serial.print(F("Controller connected on slot "));
+				Serial.println(GetSlotIndex(slot));
 #endif
 			}
 #if defined(DEBUG)
@@ -114,72 +404,534 @@ public:
 #if defined(DEBUG)
 		Serial.println(F("Connecting"));
 #endif
-		Handle = conn_hdl;
-
 		BLEConnection* conn = Bluefruit.Connection(conn_hdl);
 
-		if (XBoxService.discover(conn_hdl))
+		BleCentralSlot* slot = AssignSlot(conn->getPeerAddr());
+		if (slot == nullptr)
+		{
+			Bluefruit.disconnect(conn_hdl);
+			return;
+		}
+		slot->Handle = conn_hdl;
+
+		// Discovery already runs on the negotiated link.
+		slot->Link.Interval = conn->getConnectionInterval();
+		slot->Link.SlaveLatency = conn->getSlaveLatency();
+		slot->Link.DataLength = conn->getDataLength();
+		slot->Link.Phy = conn->getPHY();
+		NegotiateLink(*slot, BleLinkStepEnum::Interval);
+
+		slot->ConnectTimestamp = millis();
+		slot->Reported = false;
+
+		// Bonded controllers encrypt with the stored keys first, new ones pair once discovery found a controller.
+		const bool known = IsWhitelisted(conn->getPeerAddr());
+		if (known)
+		{
+			conn->requestPairing();
+		}
+
+		if (slot->Service.discover(conn_hdl)
+			&& !known)
 		{
 			conn->requestPairing();
 		}
+
+		// Keep looking for the other controllers.
+		if (!Bluefruit.Scanner.isRunning())
+		{
+			StartScan();
+		}
 	}
 
 	void OnDisconnect(uint16_t conn_hdl, uint8_t reason)
 	{
+		BleCentralSlot* slot = FindSlot(conn_hdl);
+		if (slot == nullptr)
+		{
+			return;
+		}
+
 #if defined(DEBUG)
-		Serial.println(F("Controller disconnected"));
+		Serial.print(F("Controller disconnected from slot "));
+		Serial.println(GetSlotIndex(slot));
 #endif
-		Handle = 0;
-		if (HidListener != nullptr)
+		slot->Handle = BLE_CONN_HANDLE_INVALID;
+		slot->LinkStep = BleLinkStepEnum::Done;
+		if (slot->HidListener != nullptr)
 		{
-			HidListener->OnStateChange(false);
+			slot->HidListener->OnStateChange(false);
 		}
+
+		StartReconnect();
 	}
 
 	void OnScanCallback(ble_gap_evt_adv_report_t* report)
 	{
-		Bluefruit.Central.connect(report);
-		// For Softdevice v6: after received a report, scanner will be paused
-		// We need to call Scanner resume() to continue scanning
-		Bluefruit.Scanner.resume();
+		if (FindSlot(BLE_CONN_HANDLE_INVALID) != nullptr)
+		{
+			Bluefruit.Central.connect(report);
+			// For Softdevice v6: after received a report, scanner will be paused
+			// We need to call Scanner resume() to continue scanning
+			Bluefruit.Scanner.resume();
+		}
 	}
 
 	void OnReportNotify(BLEClientCharacteristic* chr, uint8_t* data, const uint16_t len)
 	{
 		if (chr != nullptr
-			&& data != nullptr
-			&& HidListener != nullptr)
+			&& data != nullptr)
+		{
+			for (uint8_t i = 0; i < SlotCount; i++)
+			{
+				if (chr == &Slots[i].CharaReport)
+				{
+					if (!Slots[i].Reported)
+					{
+						OnFirstReport(Slots[i]);
+					}
+					if (Slots[i].HidListener != nullptr)
+					{
+						Slots[i].HidListener->OnControllerNotify(data, len, chr->uuid._uuid.uuid);
+					}
+					return;
+				}
+			}
+#if defined(DEBUG)
+			Serial.println(F("No slot match for report."));
+#endif
+		}
+	}
+
+private:
+	BleCentralSlot* FindSlot(const uint16_t conn_hdl)
+	{
+		for (uint8_t i = 0; i < SlotCount; i++)
+		{
+			if (Slots[i].Handle == conn_hdl)
+			{
+				return &Slots[i];
+			}
+		}
+
+		return nullptr;
+	}
+
+	/// <summary>
+	/// Previous slot of the peer if free, otherwise a never used slot, otherwise any free slot.
+	/// </summary>
+	BleCentralSlot* AssignSlot(const ble_gap_addr_t& address)
+	{
+		BleCentralSlot* unbound = nullptr;
+		BleCentralSlot* free = nullptr;
+		for (uint8_t i = 0; i < SlotCount; i++)
 		{
-			uint16_t uuid = 0;
-			chr->uuid.get(&uuid);
-			//XBoxService.uuid.get(&uuid);
-			//GenericGamepadService.uuid.get(&uuid);
-			//BatteryService.uuid.get(&uuid);
+			BleCentralSlot& slot = Slots[i];
+			if (slot.Connected())
+			{
+				continue;
+			}
 
-			if (uuid == UUID16_CHR_REPORT)
+			if (slot.Bound
+				&& memcmp(slot.Address.addr, address.addr, BLE_GAP_ADDR_LEN) == 0)
 			{
-				HidListener->OnControllerNotify(data, len, chr->uuid._uuid.uuid);
+				return &slot;
 			}
+			else if (!slot.Bound && unbound == nullptr)
+			{
+				unbound = &slot;
+			}
+			else if (free == nullptr)
+			{
+				free = &slot;
+			}
+		}
+
+		BleCentralSlot* slot = unbound != nullptr ? unbound : free;
+		if (slot != nullptr)
+		{
+			slot->Address = address;
+			slot->Bound = true;
+		}
+
+		return slot;
+	}
+
+#if defined(DEBUG)
+	const uint8_t GetSlotIndex(const BleCentralSlot* slot) const
+	{
+		return slot - Slots;
+	}
+#endif
+
+	void OnFirstReport(BleCentralSlot& slot)
+	{
+		const uint32_t timestamp = millis();
+
+		slot.Reported = true;
+		ReconnectStats.Count++;
+		ReconnectStats.ScanToReport = timestamp - ReconnectStart;
+		ReconnectStats.ConnectToReport = timestamp - slot.ConnectTimestamp;
+		if (ReconnectStats.ConnectToReport > ReconnectStats.ConnectToReportMax)
+		{
+			ReconnectStats.ConnectToReportMax = ReconnectStats.ConnectToReport;
+		}
+
 #if defined(DEBUG)
+		Serial.print(F("First report on slot "));
+		Serial.print(GetSlotIndex(&slot));
+		Serial.print(F(" after "));
+		Serial.print(ReconnectStats.ConnectToReport);
+		Serial.print(F(" ms connected, "));
+		Serial.print(ReconnectStats.ScanToReport);
+		Serial.println(F(" ms scanning"));
+#endif
+	}
+
+	static void OnWakeCallback(uint32_t central)
+	{
+		BleCentral* instance = (BleCentral*)central;
+		instance->WakePending = false;
+		instance->StartReconnect();
+	}
+
+	const bool IsWhitelisted(const ble_gap_addr_t& address) const
+	{
+		for (uint8_t i = 0; i < WhitelistCount; i++)
+		{
+			if (Whitelist[i].id_addr_info.addr_type == address.addr_type
+				&& memcmp(Whitelist[i].id_addr_info.addr, address.addr, BLE_GAP_ADDR_LEN) == 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Opens the reconnect window, with the cached controllers as whitelist.
+	/// </summary>
+	void StartReconnect()
+	{
+		WhitelistCount = PeerCache.GetIdentities(Whitelist, RetroBle::BleConfig::CentralScan::WhitelistSize);
+		ReconnectStart = millis();
+		Reconnecting = EventsForwarded && WhitelistCount > 0;
+		ScanStage = 0;
+
+		StartScan();
+	}
+
+	/// <summary>
+	/// Whitelist scan while the reconnect window is open, otherwise the open scan at the backoff stage duty.
+	/// Nothing to scan for when all slots are taken.
+	/// </summary>
+	void StartScan()
+	{
+		Bluefruit.Scanner.stop();
+		OnScanStageEnd();
+
+		if (FindSlot(BLE_CONN_HANDLE_INVALID) == nullptr)
+		{
+			return;
+		}
+
+		ble_gap_scan_params_t* params = Bluefruit.Scanner.getParams();
+		const uint32_t elapsed = millis() - ReconnectStart;
+		if (Reconnecting
+			&& elapsed < RetroBle::BleConfig::CentralScan::ReconnectMillis
+			&& SetWhitelist())
+		{
+			// The whitelist is the filter, directed advertising doesn't carry the service.
+			Bluefruit.Scanner.clearFilters();
+			Bluefruit.Scanner.setInterval(RetroBle::BleConfig::CentralScan::ReconnectInterval, RetroBle::BleConfig::CentralScan::ReconnectWindow);
+			params->filter_policy = BLE_GAP_SCAN_FP_WHITELIST;
+
+			// Timeout in units of 10 ms, 0 would scan forever.
+			const uint32_t timeout = (RetroBle::BleConfig::CentralScan::ReconnectMillis - elapsed) / 10;
+			OnScanStageStart(RetroBle::BleConfig::CentralScan::ReconnectInterval, RetroBle::BleConfig::CentralScan::ReconnectWindow);
+			Bluefruit.Scanner.start(timeout > 0 ? timeout : 1);
+		}
+		else
+		{
+			Reconnecting = false;
+			params->filter_policy = BLE_GAP_SCAN_FP_ACCEPT_ALL;
+			Bluefruit.Scanner.filterService(Slots[0].Service);
+			Bluefruit.Scanner.filterRssi(RetroBle::BleConfig::CentralScan::RssiMin);
+
+			const uint16_t interval = RetroBle::BleConfig::CentralScan::Interval << ScanStage;
+			Bluefruit.Scanner.setInterval(interval, RetroBle::BleConfig::CentralScan::Window);
+			OnScanStageStart(interval, RetroBle::BleConfig::CentralScan::Window);
+
+			// The background stage doesn't time out.
+			if (ScanStage < RetroBle::BleConfig::CentralScan::BackoffStages)
+			{
+				Bluefruit.Scanner.start((RetroBle::BleConfig::CentralScan::BackoffStartMillis << ScanStage) / 10);
+			}
 			else
 			{
-				Serial.print(F("No UUID Match Report: "));
-				Serial.println(uuid);
+				Bluefruit.Scanner.start(0);
 			}
+		}
+
+#if defined(DEBUG)
+		Serial.print(F("Scan duty "));
+		Serial.print(GetScanDuty());
+		Serial.print(F(" permille, radio "));
+		Serial.print(ScanRadioMillis);
+		Serial.println(F(" ms"));
 #endif
+	}
+
+	void OnScanStageStart(const uint16_t interval, const uint16_t window)
+	{
+		ScanStart = millis();
+		ScanInterval = interval;
+		ScanWindow = window;
+	}
+
+	void OnScanStageEnd()
+	{
+		ScanRadioMillis += GetStageRadioMillis(millis());
+		ScanInterval = 0;
+		ScanWindow = 0;
+	}
+
+	const uint32_t GetStageRadioMillis(const uint32_t timestamp) const
+	{
+		if (ScanInterval == 0)
+		{
+			return 0;
+		}
+
+		return ((uint64_t)(timestamp - ScanStart) * ScanWindow) / ScanInterval;
+	}
+
+	/// <summary>
+	/// Identity addresses as the whitelist, with the IRKs of the peers that have one as device identities.
+	/// The SoftDevice resolves their private addresses against the whitelist,
+	/// and reports the connection with the identity address.
+	/// The scanner must be stopped, the lists can't change while in use.
+	/// </summary>
+	const bool SetWhitelist() const
+	{
+		const ble_gap_addr_t* addresses[RetroBle::BleConfig::CentralScan::WhitelistSize];
+		const ble_gap_id_key_t* identities[RetroBle::BleConfig::CentralScan::WhitelistSize];
+		uint8_t identityCount = 0;
+		for (uint8_t i = 0; i < WhitelistCount; i++)
+		{
+			addresses[i] = &Whitelist[i].id_addr_info;
+			if (BlePeerCache::HasIrk(Whitelist[i]))
+			{
+				identities[identityCount++] = &Whitelist[i];
+			}
+		}
+
+		// Without identities, only the peers on their identity address are matched.
+		sd_ble_gap_device_identities_set(identityCount > 0 ? identities : nullptr, nullptr, identityCount);
+
+		return sd_ble_gap_whitelist_set(addresses, WhitelistCount) == NRF_SUCCESS;
+	}
+
+	/// <summary>
+	/// Starts the link procedure of the step, the next one starts on its completion event.
+	/// The controller stack only runs one procedure at a time.
+	/// A step that is already granted or can't be requested is skipped.
+	/// </summary>
+	void NegotiateLink(BleCentralSlot& slot, BleLinkStepEnum step)
+	{
+		BLEConnection* conn = Bluefruit.Connection(slot.Handle);
+		if (conn == nullptr)
+		{
+			slot.LinkStep = BleLinkStepEnum::Done;
+			return;
+		}
+
+		while (step != BleLinkStepEnum::Done)
+		{
+			slot.LinkStep = step;
+
+			bool requested = false;
+			BleLinkStepEnum next = BleLinkStepEnum::Done;
+			switch (step)
+			{
+			case BleLinkStepEnum::Interval:
+				requested = (slot.Link.Interval > RetroBle::BleConfig::CentralLink::Interval
+					|| slot.Link.SlaveLatency != RetroBle::BleConfig::CentralLink::SlaveLatency)
+					&& conn->requestConnectionParameter(RetroBle::BleConfig::CentralLink::Interval,
+						RetroBle::BleConfig::CentralLink::SlaveLatency,
+						RetroBle::BleConfig::CentralLink::SupervisionTimeout);
+				next = BleLinkStepEnum::Phy;
+				break;
+			case BleLinkStepEnum::Phy:
+				requested = slot.Link.Phy != RetroBle::BleConfig::CentralLink::Phy
+					&& conn->requestPHY(RetroBle::BleConfig::CentralLink::Phy);
+				next = BleLinkStepEnum::DataLength;
+				break;
+			case BleLinkStepEnum::DataLength:
+				// Automatic parameters, the longest both sides support.
+				requested = conn->requestDataLengthUpdate();
+				next = BleLinkStepEnum::Done;
+				break;
+			case BleLinkStepEnum::Done:
+			default:
+				break;
+			}
+
+			if (requested)
+			{
+				return;
+			}
+			step = next;
+		}
+
+		slot.LinkStep = BleLinkStepEnum::Done;
+
+#if defined(DEBUG)
+		Serial.print(F("Link on slot "));
+		Serial.print(GetSlotIndex(&slot));
+		Serial.print(F(": interval "));
+		Serial.print(slot.Link.Interval * 1.25f);
+		Serial.print(F(" ms, latency "));
+		Serial.print(slot.Link.SlaveLatency);
+		Serial.print(F(", PHY "));
+		Serial.print(slot.Link.Phy == BLE_GAP_PHY_2MBPS ? F("2M") : F("1M"));
+		Serial.print(F(", data length "));
+		Serial.println(slot.Link.DataLength);
+#endif
+	}
+
+	/// <summary>
+	/// Restore a bonded controller from the cache, skipping characteristic discovery and the report map read.
+	/// Only the report CCCD is looked up again, so stale handles fail here and fall back to full discovery.
+	/// </summary>
+	const bool EnableCached(BleCentralSlot& slot)
+	{
+		BLEConnection* conn = Bluefruit.Connection(slot.Handle);
+		if (slot.HidListener == nullptr
+			|| !conn->bonded())
+		{
+			return false;
+		}
+
+		ble_gap_id_key_t identity;
+		if (!GetIdentity(conn, identity)
+			|| !PeerCache.Load(identity.id_addr_info, PeerEntry))
+		{
+			return false;
+		}
+
+		ble_gattc_char_t chr{};
+		chr.uuid.type = BLE_UUID_TYPE_BLE;
+		chr.uuid.uuid = UUID16_CHR_REPORT;
+		chr.char_props.read = 1;
+		chr.char_props.notify = 1;
+		chr.handle_decl = PeerEntry.ReportHandle - 1;
+		chr.handle_value = PeerEntry.ReportHandle;
+		slot.CharaReport._assign(&chr);
+
+		const ble_gattc_handle_range_t range{ (uint16_t)(PeerEntry.ReportHandle + 1), PeerEntry.ReportDescriptorEnd };
+
+		slot.HidListener->OnReportProgram(PeerEntry.Program);
+
+		if (slot.CharaReport._discoverDescriptor(slot.Handle, range)
+			&& slot.CharaReport.enableNotify())
+		{
+			return true;
+		}
+
+#if defined(DEBUG)
+		Serial.println(F("Peer cache stale, discovering."));
+#endif
+		PeerCache.Remove(identity.id_addr_info);
+
+		return false;
+	}
+
+	/// <summary>
+	/// Every bonded controller is saved, as the cache is also the reconnect whitelist.
+	/// Without a compiled program, the entry only serves the whitelist and the next connection runs full discovery.
+	/// </summary>
+	void SaveCache(BleCentralSlot& slot)
+	{
+		BLEConnection* conn = Bluefruit.Connection(slot.Handle);
+		ble_gap_id_key_t identity;
+		if (!conn->bonded()
+			|| !GetIdentity(conn, identity))
+		{
+			return;
+		}
+
+		if (slot.HidListener == nullptr
+			|| !slot.HidListener->GetReportProgram(PeerEntry.Program))
+		{
+			PeerEntry.Program = {};
+		}
+
+		// HID reports keep their CCCD next to the value, followed by the report reference.
+		PeerEntry.ReportHandle = slot.CharaReport.valueHandle();
+		PeerEntry.ReportDescriptorEnd = PeerEntry.ReportHandle + 2;
+
+		PeerCache.Save(identity, PeerEntry);
+	}
+
+	/// <summary>
+	/// The identity address and IRK distributed with the bond keys, or the connection address when it's already public or static.
+	/// A peer on a resolvable address that didn't share its identity can't be recognized again and isn't cached.
+	/// </summary>
+	static const bool GetIdentity(BLEConnection* conn, ble_gap_id_key_t& identity)
+	{
+		bond_keys_t keys{};
+		if (conn->loadKeys(&keys)
+			&& BlePeerCache::IsIdentity(keys.peer_id.id_addr_info))
+		{
+			identity = keys.peer_id;
+		}
+		else
+		{
+			identity = {};
+			identity.id_addr_info = conn->getPeerAddr();
+		}
+		identity.id_addr_info.addr_id_peer = 0;
+
+		return BlePeerCache::IsIdentity(identity.id_addr_info);
+	}
+
+	/// <summary>
+	/// Long read of the report map, forwarded to the listener for compilation.
+	/// An empty map leaves the listener on its fixed mappings.
+	/// The buffer is shared, connection callbacks are serialized.
+	/// </summary>
+	void ReadReportMap(BleCentralSlot& slot)
+	{
+		const uint16_t size = slot.CharaReportMap.read(ReportMap, sizeof(ReportMap));
+
+#if defined(DEBUG)
+		Serial.print(F("Report map size: "));
+		Serial.println(size);
+#endif
+		if (slot.HidListener != nullptr)
+		{
+			slot.HidListener->OnReportMap(ReportMap, size);
 		}
 	}
 
-private:
 	void SetupBle(void (*onConnect)(const uint16_t conn_hdl),
 		void (*onDisconnect)(const uint16_t conn_hdl, const uint8_t reason),
 		void (*onScanCallback)(ble_gap_evt_adv_report_t* report),
-		void (*onConnectionSecured)(uint16_t conn_handle))
+		void (*onConnectionSecured)(uint16_t conn_handle),
+		void (*onBleEvent)(ble_evt_t* bleEvent))
 	{
+		// Room for 2M PHY and data length extension, with the event length budget split among the slots.
+		Bluefruit.configCentralConn(RetroBle::BleConfig::CentralLink::Mtu,
+			GetEventLength(),
+			BLE_GATTS_HVN_TX_QUEUE_SIZE_DEFAULT,
+			BLE_GATTC_WRITE_CMD_TX_QUEUE_SIZE_DEFAULT);
+
 		// Initialize Bluefruit with maximum connections as Peripheral = 0, Central =
-		// 1 SRAM usage required by SoftDevice will increase dramatically with number
+		// SlotCount SRAM usage required by SoftDevice will increase dramatically with number
 		// of connections
-		Bluefruit.begin(0, 1);
+		Bluefruit.begin(0, SlotCount);
 		Bluefruit.setTxPower(RetroBle::BleConfig::TxPower);  // Check bluefruit.h for supported values
 
 		/* Set the device name */
@@ -191,14 +943,22 @@ private:
 
 		Bluefruit.Central.setConnectCallback(onConnect);
 		Bluefruit.Central.setDisconnectCallback(onDisconnect);
+		Bluefruit.Central.setConnInterval(RetroBle::BleConfig::CentralLink::Interval, RetroBle::BleConfig::CentralLink::Interval);
+		if (onBleEvent != nullptr)
+		{
+			Bluefruit.setEventCallback(onBleEvent);
+			EventsForwarded = true;
+		}
 		Bluefruit.Security.setSecuredCallback(onConnectionSecured);
 		Bluefruit.Scanner.setRxCallback(onScanCallback);
-		Bluefruit.Scanner.restartOnDisconnect(true);
-		Bluefruit.Scanner.filterService(XBoxService);
-		Bluefruit.Scanner.filterRssi(-80);
-		Bluefruit.Scanner.setInterval(160, 80);  // in units of 0.625 ms
+		Bluefruit.Scanner.restartOnDisconnect(false); // Restarted in reconnect mode.
 		Bluefruit.Scanner.useActiveScan(true);   // Request scan response data
-		Bluefruit.Scanner.start(0);  // 0 = Don't stop scanning after n seconds
+	}
+
+	static constexpr uint16_t GetEventLength()
+	{
+		return (RetroBle::BleConfig::CentralLink::EventLength / SlotCount) > BLE_GAP_EVENT_LENGTH_MIN ?
+			(RetroBle::BleConfig::CentralLink::EventLength / SlotCount) : BLE_GAP_EVENT_LENGTH_MIN;
 	}
 };
 #endif
@@ -54,12 +54,105 @@ namespace RetroBle
 			static constexpr uint8_t Max = Min + 1;
 		};
 
+		/// <summary>
+		/// Central link negotiation, requested on each controller connection.
+		/// </summary>
+		namespace CentralLink
+		{
+			/// <summary>
+			/// Requested connection interval, in units of 1.25 ms.
+			/// </summary>
+			static constexpr uint16_t Interval = ConnectionIntervalFast::Min;
+
+			static constexpr uint16_t SlaveLatency = 0;
+
+			/// <summary>
+			/// Supervision timeout, in units of 10 ms.
+			/// </summary>
+			static constexpr uint16_t SupervisionTimeout = 200;
+
+			static constexpr uint8_t Phy = BLE_GAP_PHY_2MBPS;
+
+			static constexpr uint16_t Mtu = 247;
+
+			/// <summary>
+			/// Connection event length, in units of 1.25 ms, split among the central slots.
+			/// </summary>
+			static constexpr uint16_t EventLength = 6;
+		};
+
+		/// <summary>
+		/// Central scanning, intervals and windows in units of 0.625 ms.
+		/// </summary>
+		namespace CentralScan
+		{
+			/// <summary>
+			/// Open scan, for new controllers.
+			/// Starts at Window/Interval duty, each backoff stage doubles the interval for twice as long as the previous,
+			/// until it settles on the background duty (Interval << BackoffStages).
+			/// </summary>
+			static constexpr uint16_t Interval = 160;
+			static constexpr uint16_t Window = 80;
+			static constexpr int8_t RssiMin = -80;
+			static constexpr uint8_t BackoffStages = 4;
+			static constexpr uint32_t BackoffStartMillis = 10000;
+
+			/// <summary>
+			/// Continuous whitelist scan for the bonded controllers, after boot or a disconnect.
+			/// </summary>
+			static constexpr uint16_t ReconnectInterval = 48;
+			static constexpr uint16_t ReconnectWindow = 48;
+			static constexpr uint32_t ReconnectMillis = 10000;
+
+			static constexpr uint8_t WhitelistSize = BLE_GAP_WHITELIST_ADDR_MAX_COUNT;
+		};
+
 		static constexpr uint32_t BATTERY_UPDATE_PERIOD_MILLIS = 3000;
 
+		/// <summary>
+		/// HID reports are only sent on change.
+		/// Optional period to re-send an unchanged report, 0 to disable.
+		/// </summary>
+		static constexpr uint32_t REPORT_HEARTBEAT_PERIOD_MILLIS = 0;
+
+		/// <summary>
+		/// Input sampling period between reports, latched until the next report.
+		/// </summary>
+		static constexpr uint32_t INPUT_SAMPLE_PERIOD_MILLIS = 1;
+
+		/// <summary>
+		/// Input sampling slows down through these tiers while idle.
+		/// After IdleMillis without activity, input is sampled every PeriodMillis.
+		/// </summary>
+		namespace IdleSampling
+		{
+			static constexpr uint8_t TierCount = 3;
+			static constexpr uint32_t IdleMillis[TierCount] = { 500, 5000, 30000 };
+			static constexpr uint32_t PeriodMillis[TierCount] = { 4, 8, 16 };
+
+			/// <summary>
+			/// Wake edges raised by the input interrupt are polled this often between idle samples.
+			/// </summary>
+			static constexpr uint32_t WakePollMillis = 1;
+		}
+
 		static constexpr uint32_t ADVERTISE_FAST_TIMEOUT_MILLIS = 15000;
 		static constexpr uint32_t ADVERTISE_NO_ACTIVITY_TIMEOUT_MILLIS = 30000;
 
+		/// <summary>
+		/// Connected device goes to sleep after this long without activity, 0 to disable.
+		/// </summary>
 		static constexpr uint32_t CONNECTED_NO_ACTIVITY_TIMEOUT_MILLIS = 5 * 60000;
+
+		/// <summary>
+		/// Axis movement that counts as activity, in HID report units [-127 ; 127].
+		/// </summary>
+		static constexpr uint8_t ACTIVITY_ANALOG_DEADBAND = 8;
+
+		/// <summary>
+		/// Largest HID report map read from a controller, as allowed by the HID over GATT profile.
+		/// </summary>
+		static constexpr uint16_t REPORT_MAP_MAX_SIZE = 512;
 	}
 }
 #endif
@@ -0,0 +1,304 @@
+// BlePeerCache.h
+
+#ifndef _BLE_PEER_CACHE_h
+#define _BLE_PEER_CACHE_h
+
+#if defined(ARDUINO_ARCH_NRF52)
+#include <Adafruit_LittleFS.h>
+#include <InternalFileSystem.h>
+#include <bluefruit.h>
+
+#include "../Framework/InternalFile.h"
+#include "BleConfig.h"
+#include "../HidHost/HidReportParser.h"
+
+/// <summary>
+/// What a reconnecting controller needs, without discovery or report map read.
+/// </summary>
+struct BlePeerEntryStruct
+{
+	/// <summary>
+	/// Report characteristic value handle.
+	/// </summary>
+	uint16_t ReportHandle;
+
+	/// <summary>
+	/// Last handle of the report characteristic descriptors, to find its CCCD.
+	/// </summary>
+	uint16_t ReportDescriptorEnd;
+
+	HidReport::ProgramStruct Program;
+};
+
+/// <summary>
+/// Per-peer cache of attribute handles and the compiled report map, persisted in the internal file system.
+/// Keyed by the peer identity address, only bonded peers are cached.
+/// The cached addresses double as the reconnect whitelist, so peers without a program are cached too,
+/// but only entries with a program are loaded.
+/// Holds up to MaxPeers entries, saving a new peer evicts the least recently saved one.
+/// </summary>
+class BlePeerCache
+{
+public:
+	static constexpr uint8_t MaxPeers = RetroBle::BleConfig::CentralScan::WhitelistSize;
+
+private:
+	static constexpr uint8_t FormatVersion = 4;
+	static constexpr uint8_t PathSize = sizeof("/peer/000000000000");
+
+	struct FileStruct
+	{
+		uint8_t Version;
+		uint8_t AddressType;
+		uint8_t Address[BLE_GAP_ADDR_LEN];
+
+		/// <summary>
+		/// Peer IRK, all zeros if the peer doesn't use resolvable addresses.
+		/// </summary>
+		ble_gap_irk_t Irk;
+
+		/// <summary>
+		/// Save order, for eviction.
+		/// </summary>
+		uint32_t Sequence;
+
+		BlePeerEntryStruct Entry;
+	};
+
+private:
+	bool Ready = false;
+
+public:
+	/// <summary>
+	/// Call after Bluefruit.begin(), which mounts the file system.
+	/// </summary>
+	const bool Setup()
+	{
+		Ready = InternalFS.begin();
+
+		if (Ready
+			&& !InternalFS.exists("/peer"))
+		{
+			InternalFS.mkdir("/peer");
+		}
+
+		return Ready;
+	}
+
+	/// <summary>
+	/// Only public and random static addresses identify a peer across connections.
+	/// </summary>
+	static const bool IsIdentity(const ble_gap_addr_t& address)
+	{
+		return address.addr_type == BLE_GAP_ADDR_TYPE_PUBLIC
+			|| address.addr_type == BLE_GAP_ADDR_TYPE_RANDOM_STATIC;
+	}
+
+	const bool Load(const ble_gap_addr_t& address, BlePeerEntryStruct& entry) const
+	{
+		if (!Ready)
+		{
+			return false;
+		}
+
+		char path[PathSize];
+		GetPath(path, address);
+
+		FileStruct file{};
+		if (InternalFile::Read(path, &file, sizeof(file)) != sizeof(file)
+			|| file.Version != FormatVersion
+			|| file.AddressType != address.addr_type
+			|| memcmp(file.Address, address.addr, BLE_GAP_ADDR_LEN) != 0
+			|| file.Entry.Program.Count == 0
+			|| file.Entry.Program.Count > HidReport::ProgramStruct::MaxFields)
+		{
+			return false;
+		}
+
+		entry = file.Entry;
+
+		return true;
+	}
+
+	/// <summary>
+	/// Store or replace the peer entry, evicting the oldest others beyond MaxPeers.
+	/// </summary>
+	/// <param name="identity">Identity address, never a private one, and the IRK if the peer distributed it.</param>
+	const bool Save(const ble_gap_id_key_t& identity, const BlePeerEntryStruct& entry)
+	{
+		const ble_gap_addr_t& address = identity.id_addr_info;
+		if (!Ready
+			|| !IsIdentity(address))
+		{
+			return false;
+		}
+
+		char path[PathSize];
+		GetPath(path, address);
+
+		const uint32_t sequence = Evict(&path[sizeof("/peer/") - 1]);
+
+		FileStruct file{};
+		file.Version = FormatVersion;
+		file.AddressType = address.addr_type;
+		memcpy(file.Address, address.addr, BLE_GAP_ADDR_LEN);
+		file.Irk = identity.id_info;
+		file.Sequence = sequence + 1;
+		file.Entry = entry;
+
+		return InternalFile::Write(path, &file, sizeof(file));
+	}
+
+	static const bool HasIrk(const ble_gap_id_key_t& identity)
+	{
+		for (uint8_t i = 0; i < BLE_GAP_SEC_KEY_LEN; i++)
+		{
+			if (identity.id_info.irk[i] != 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Cached peer identity addresses and IRKs.
+	/// </summary>
+	/// <returns>Identity count.</returns>
+	const uint8_t GetIdentities(ble_gap_id_key_t* identities, const uint8_t maxCount) const
+	{
+		using namespace Adafruit_LittleFS_Namespace;
+
+		if (!Ready)
+		{
+			return 0;
+		}
+
+		File directory(InternalFS);
+		if (!directory.open("/peer", FILE_O_READ))
+		{
+			return 0;
+		}
+
+		uint8_t count = 0;
+		while (count < maxCount)
+		{
+			File file = directory.openNextFile(FILE_O_READ);
+			if (!file)
+			{
+				break;
+			}
+
+			FileStruct entry{};
+			const int read = file.read(&entry, sizeof(entry));
+			file.close();
+
+			if (read == sizeof(entry)
+				&& entry.Version == FormatVersion)
+			{
+				identities[count] = {};
+				identities[count].id_info = entry.Irk;
+				identities[count].id_addr_info.addr_type = entry.AddressType;
+				memcpy(identities[count].id_addr_info.addr, entry.Address, BLE_GAP_ADDR_LEN);
+				count++;
+			}
+		}
+		directory.close();
+
+		return count;
+	}
+
+	/// <summary>
+	/// Drop a stale entry, e.g. the peer firmware changed its attribute table.
+	/// </summary>
+	void Remove(const ble_gap_addr_t& address)
+	{
+		if (Ready)
+		{
+			char path[PathSize];
+			GetPath(path, address);
+			InternalFS.remove(path);
+		}
+	}
+
+private:
+	/// <summary>
+	/// Remove the oldest entries until there's room for one more besides the kept one.
+	/// Entries of another format version are the first to go.
+	/// </summary>
+	/// <param name="keepName">File name of the entry about to be saved.</param>
+	/// <returns>Highest stored sequence.</returns>
+	const uint32_t Evict(const char* keepName)
+	{
+		using namespace Adafruit_LittleFS_Namespace;
+
+		uint32_t newest = 0;
+		while (true)
+		{
+			File directory(InternalFS);
+			if (!directory.open("/peer", FILE_O_READ))
+			{
+				return newest;
+			}
+
+			char oldestPath[PathSize]{};
+			uint32_t oldest = UINT32_MAX;
+			uint8_t count = 0;
+			while (true)
+			{
+				File file = directory.openNextFile(FILE_O_READ);
+				if (!file)
+				{
+					break;
+				}
+
+				const char* name = file.name();
+				if (strlen(name) == (PathSize - sizeof("/peer/"))
+					&& strcmp(name, keepName) != 0)
+				{
+					FileStruct entry{};
+					const int read = file.read(&entry, sizeof(entry));
+					const uint32_t sequence = (read == sizeof(entry) && entry.Version == FormatVersion) ? entry.Sequence : 0;
+
+					if (sequence > newest)
+					{
+						newest = sequence;
+					}
+					if (sequence < oldest)
+					{
+						oldest = sequence;
+						memcpy(oldestPath, "/peer/", sizeof("/peer/") - 1);
+						strcpy(&oldestPath[sizeof("/peer/") - 1], name);
+					}
+					count++;
+				}
+				file.close();
+			}
+			directory.close();
+
+			if (count < MaxPeers
+				|| !InternalFS.remove(oldestPath))
+			{
+				return newest;
+			}
+		}
+	}
+
+	static void GetPath(char(&path)[PathSize], const ble_gap_addr_t& address)
+	{
+		static constexpr char Hex[] = "0123456789ABCDEF";
+
+		memcpy(path, "/peer/", sizeof("/peer/") - 1);
+		char* name = &path[sizeof("/peer/") - 1];
+		for (uint8_t i = 0; i < BLE_GAP_ADDR_LEN; i++)
+		{
+			const uint8_t value = address.addr[BLE_GAP_ADDR_LEN - 1 - i];
+			*name++ = Hex[value >> 4];
+			*name++ = Hex[value & 0x0F];
+		}
+		*name = '\0';
+	}
+};
+#endif
+#endif
@@ -9,6 +9,7 @@
 #include <bluefruit.h>
 
 #include "BleConfig.h"
+#include "IBleListener.h"
 
 #include "../Framework/RetroBleDevice.h"
 
@@ -36,6 +37,7 @@ private:
 
 private:
 	IBleListener* Listener = nullptr;
+	IBleTxListener* TxListener = nullptr;
 	uint16_t Handle = 0;
 
 public:
@@ -69,6 +71,11 @@ public:
 		Listener = listener;
 	}
 
+	void SetTxListener(IBleTxListener* txListener)
+	{
+		TxListener = txListener;
+	}
+
 	const bool IsConnected()
 	{
 		return Bluefruit.connected();
@@ -100,9 +107,11 @@ public:
 	/// <param name="chargePercentage"></param>
 	void NotifyBattery(const uint8_t chargePercentage)
 	{
-		if (IsConnected())
+		if (IsConnected()
+			&& BleBattery.notify(chargePercentage)
+			&& TxListener != nullptr)
 		{
-			BleBattery.notify(chargePercentage);
+			TxListener->OnBleTxOther();
 		}
 	}
 
@@ -144,7 +153,18 @@ public:
 
 	void OnBleEventInterrupt(ble_evt_t* bleEvent)
 	{
-		//TODO: Forward event to relevant listener.
+		//TODO: Forward remaining events to relevant listener.
+		switch (bleEvent->header.evt_id)
+		{
+		case BLE_GATTS_EVT_HVN_TX_COMPLETE:
+			if (TxListener != nullptr)
+			{
+				TxListener->OnBleTxComplete(bleEvent->evt.gatts_evt.params.hvn_tx_complete.count);
+			}
+			break;
+		default:
+			break;
+		}
 	}
 
 private:
@@ -0,0 +1,157 @@
+// BleRadioSync.h
+
+#ifndef _BLE_RADIO_SYNC_h
+#define _BLE_RADIO_SYNC_h
+
+#if defined(ARDUINO_ARCH_NRF52)
+#include <Adafruit_LittleFS.h>
+#include <InternalFileSystem.h>
+#include <bluefruit.h>
+#include <nrf_soc.h>
+
+/// <summary>
+/// Tracks the SoftDevice radio notifications, to align input sampling with the connection events.
+/// The notification fires a fixed distance (the sampling margin) before the radio goes active.
+/// Interval is measured between notifications, so the next one can be predicted.
+/// RADIO_NOTIFICATION_IRQHandler must be forwarded to OnRadioNotificationInterrupt.
+/// </summary>
+class BleRadioSync
+{
+private:
+	/// <summary>
+	/// Notifications missing for this many intervals drops the lock.
+	/// </summary>
+	static constexpr uint8_t LockTimeoutIntervals = 3;
+
+	/// <summary>
+	/// Consecutive long intervals accepted as a new connection interval.
+	/// </summary>
+	static constexpr uint8_t IntervalChangeCount = 2;
+
+	/// <summary>
+	/// Application interrupt priority, lowest allowed with the SoftDevice.
+	/// </summary>
+	static constexpr uint8_t IrqPriority = 6;
+
+private:
+	volatile uint32_t Timestamp = 0;
+	volatile uint32_t Interval = 0;
+	volatile uint32_t Count = 0;
+	uint8_t LongIntervals = 0;
+
+public:
+	/// <summary>
+	/// Enable radio notifications, must be called after Bluefruit.begin() and before advertising.
+	/// </summary>
+	/// <param name="distance">NRF_RADIO_NOTIFICATION_DISTANCE_*, sampling margin before each connection event.</param>
+	/// <returns>True if the SoftDevice accepted the configuration.</returns>
+	const bool Setup(const uint8_t distance)
+	{
+		if (sd_radio_notification_cfg_set(NRF_RADIO_NOTIFICATION_TYPE_INT_ON_ACTIVE, distance) != NRF_SUCCESS)
+		{
+			return false;
+		}
+
+		sd_nvic_ClearPendingIRQ(RADIO_NOTIFICATION_IRQn);
+		sd_nvic_SetPriority(RADIO_NOTIFICATION_IRQn, IrqPriority);
+		sd_nvic_EnableIRQ(RADIO_NOTIFICATION_IRQn);
+
+		return true;
+	}
+
+	void Stop()
+	{
+		sd_nvic_DisableIRQ(RADIO_NOTIFICATION_IRQn);
+		sd_radio_notification_cfg_set(NRF_RADIO_NOTIFICATION_TYPE_NONE, 0);
+		Interval = 0;
+		Count = 0;
+	}
+
+	/// <summary>
+	/// Radio is about to go active, i.e. the margin before the next radio event.
+	/// </summary>
+	void OnRadioNotificationInterrupt()
+	{
+		const uint32_t timestamp = micros();
+		const uint32_t delta = timestamp - Timestamp;
+
+		if (Count == 0
+			|| Interval == 0)
+		{
+			Interval = (Count == 0) ? 0 : delta;
+		}
+		else if (delta <= (Interval + (Interval / 2)))
+		{
+			Interval = delta;
+			LongIntervals = 0;
+		}
+		else if (++LongIntervals >= IntervalChangeCount)
+		{
+			// Skipped events look the same as a slower interval, until they repeat.
+			Interval = delta;
+			LongIntervals = 0;
+		}
+
+		Timestamp = timestamp;
+		Count++;
+	}
+
+	/// <summary>
+	/// Notification counter, changes on every radio event.
+	/// </summary>
+	const uint32_t GetCount() const
+	{
+		return Count;
+	}
+
+	/// <summary>
+	/// Notifications are arriving at a known interval.
+	/// </summary>
+	/// <param name="timestamp">Current micros().</param>
+	const bool IsLocked(const uint32_t timestamp) const
+	{
+		uint32_t last, interval;
+		GetSnapshot(last, interval);
+
+		return interval > 0
+			&& (timestamp - last) < (interval * LockTimeoutIntervals);
+	}
+
+	/// <summary>
+	/// Milliseconds until the next predicted notification, rounded up so it has already fired on wake.
+	/// </summary>
+	/// <param name="timestamp">Current micros().</param>
+	/// <returns>[1 ; interval+1] ms, 1 if not locked.</returns>
+	const uint32_t GetMillisToNext(const uint32_t timestamp) const
+	{
+		uint32_t last, interval;
+		GetSnapshot(last, interval);
+
+		if (interval == 0)
+		{
+			return 1;
+		}
+
+		const uint32_t remaining = interval - ((timestamp - last) % interval);
+		const uint32_t millisToNext = (remaining + 999) / 1000;
+
+		return millisToNext > 0 ? millisToNext : 1;
+	}
+
+private:
+	/// <summary>
+	/// Consistent read of the interrupt owned values.
+	/// </summary>
+	void GetSnapshot(uint32_t& timestamp, uint32_t& interval) const
+	{
+		uint32_t count;
+		do
+		{
+			count = Count;
+			timestamp = Timestamp;
+			interval = Interval;
+		} while (count != Count);
+	}
+};
+#endif
+#endif
@@ -0,0 +1,76 @@
+// BleTxOrder.h
+
+#ifndef _BLE_TX_ORDER_h
+#define _BLE_TX_ORDER_h
+
+#include <stdint.h>
+#include <atomic>
+
+/// <summary>
+/// Queue order of the notifications pending on a connection, own and others (e.g. battery level).
+/// The SoftDevice completes notifications in queue order with a count only,
+/// so the own completions are told apart by replaying that order.
+/// Notifications are queued from the loop task and completed from the BLE task,
+/// the whole order is a single atomic word, updated with compare and swap.
+/// </summary>
+class BleTxOrder
+{
+private:
+	static constexpr uint8_t CountShift = 24;
+	static constexpr uint32_t OwnMask = ((uint32_t)1 << CountShift) - 1;
+
+	static constexpr uint8_t Capacity = CountShift;
+
+private:
+	// Pending count in the top byte, own flags below, oldest at bit 0.
+	std::atomic<uint32_t> Order{ 0 };
+
+public:
+	void Clear()
+	{
+		Order.store(0, std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// A notification was queued, untracked past Capacity.
+	/// </summary>
+	void OnQueued(const bool own)
+	{
+		uint32_t order = Order.load(std::memory_order_relaxed);
+		uint32_t next;
+		do
+		{
+			const uint8_t count = order >> CountShift;
+			if (count >= Capacity)
+			{
+				return;
+			}
+
+			next = (order | ((uint32_t)own << count)) + ((uint32_t)1 << CountShift);
+		} while (!Order.compare_exchange_weak(order, next, std::memory_order_relaxed));
+	}
+
+	/// <summary>
+	/// Pops the completed notifications, oldest first.
+	/// </summary>
+	/// <param name="count">Completed notifications, from BLE_GATTS_EVT_HVN_TX_COMPLETE.</param>
+	/// <returns>How many of those were own.</returns>
+	const uint8_t OnComplete(const uint8_t count)
+	{
+		uint32_t order = Order.load(std::memory_order_relaxed);
+		uint32_t next;
+		uint8_t completedOwn;
+		do
+		{
+			const uint8_t pending = order >> CountShift;
+			const uint8_t completed = count < pending ? count : pending;
+			const uint32_t flags = order & OwnMask;
+
+			completedOwn = __builtin_popcount(flags & (((uint32_t)1 << completed) - 1));
+			next = (flags >> completed) | ((uint32_t)(pending - completed) << CountShift);
+		} while (!Order.compare_exchange_weak(order, next, std::memory_order_relaxed));
+
+		return completedOwn;
+	}
+};
+#endif
@@ -10,5 +10,22 @@ public:
 
 	virtual void OnBleBackReport(uint8_t report_id, uint8_t report_type, uint8_t const* buffer, uint16_t bufsize) = 0;
 };
+
+/// <summary>
+/// Listener for completed BLE notifications.
+/// </summary>
+class IBleTxListener
+{
+public:
+	/// <summary>
+	/// Notifications completed on the connection, including the ones from OnBleTxOther.
+	/// </summary>
+	virtual void OnBleTxComplete(const uint8_t count) = 0;
+
+	/// <summary>
+	/// A notification that isn't the listener's was queued, e.g. battery level.
+	/// </summary>
+	virtual void OnBleTxOther() = 0;
+};
 #endif
 
@@ -0,0 +1,36 @@
+// IHidListener.h
+
+#ifndef _I_HID_LISTENER_h
+#define _I_HID_LISTENER_h
+
+#include <stdint.h>
+
+#include "../HidHost/HidReportParser.h"
+
+class IHidListener
+{
+public:
+	/// <summary>
+	/// Input report notification.
+	/// </summary>
+	/// <param name="uuid">Report characteristic UUID, the same for every controller.</param>
+	virtual void OnControllerNotify(uint8_t* data, const uint16_t size, const uint16_t uuid) {}
+	virtual void OnStateChange(const bool connected) {}
+
+	/// <summary>
+	/// HID report map, read once on connection before notifications are enabled.
+	/// </summary>
+	virtual void OnReportMap(const uint8_t* data, const uint16_t size) {}
+
+	/// <summary>
+	/// Cached compiled report map, replaces OnReportMap for known controllers.
+	/// </summary>
+	virtual void OnReportProgram(const HidReport::ProgramStruct& program) {}
+
+	/// <summary>
+	/// Compiled report map, to cache for the controller.
+	/// </summary>
+	/// <returns>False if there is nothing to cache.</returns>
+	virtual const bool GetReportProgram(HidReport::ProgramStruct& program) { return false; }
+};
+#endif
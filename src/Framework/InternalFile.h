@@ -0,0 +1,60 @@
+// InternalFile.h
+
+#ifndef _INTERNAL_FILE_h
+#define _INTERNAL_FILE_h
+
+#if defined(ARDUINO_ARCH_NRF52)
+#include <Adafruit_LittleFS.h>
+#include <InternalFileSystem.h>
+
+/// <summary>
+/// Whole-file access to the internal file system, for small persisted records.
+/// InternalFS must be started by the caller.
+/// </summary>
+namespace InternalFile
+{
+	/// <returns>Bytes read, 0 if the file doesn't exist.</returns>
+	inline const uint16_t Read(const char* path, void* data, const uint16_t size)
+	{
+		using namespace Adafruit_LittleFS_Namespace;
+
+		File file(InternalFS);
+		if (!file.open(path, FILE_O_READ))
+		{
+			return 0;
+		}
+
+		const int read = file.read(data, size);
+		file.close();
+
+		return read > 0 ? read : 0;
+	}
+
+	/// <summary>
+	/// Replaces the file contents.
+	/// </summary>
+	/// <returns>False if the record wasn't fully written.</returns>
+	inline const bool Write(const char* path, const void* data, const uint16_t size)
+	{
+		using namespace Adafruit_LittleFS_Namespace;
+
+		// Write appends, start from an empty file.
+		if (InternalFS.exists(path))
+		{
+			InternalFS.remove(path);
+		}
+
+		File file(InternalFS);
+		if (!file.open(path, FILE_O_WRITE))
+		{
+			return false;
+		}
+
+		const size_t written = file.write((const uint8_t*)data, size);
+		file.close();
+
+		return written == size;
+	}
+}
+#endif
+#endif
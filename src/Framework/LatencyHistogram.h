@@ -0,0 +1,140 @@
+// LatencyHistogram.h
+
+#ifndef _LATENCY_HISTOGRAM_h
+#define _LATENCY_HISTOGRAM_h
+
+#include <stdint.h>
+
+/// <summary>
+/// Latency summary, in microseconds.
+/// </summary>
+struct __attribute__((packed)) LatencySummaryStruct
+{
+	uint32_t Count = 0;
+	uint32_t Min = 0;
+	uint32_t Average = 0;
+	uint32_t P99 = 0;
+	uint32_t Max = 0;
+};
+
+/// <summary>
+/// Fixed size logarithmic histogram of microsecond latencies.
+/// Each power of 2 is split in 4 linear steps, so percentiles are within ~12%.
+/// Min, max and average are exact.
+/// </summary>
+class LatencyHistogram
+{
+private:
+	static constexpr uint8_t SubBits = 2;
+	static constexpr uint8_t SubSteps = 1 << SubBits;
+	static constexpr uint8_t Octaves = 24; // Up to ~16 s.
+	static constexpr uint8_t BucketCount = Octaves * SubSteps;
+
+private:
+	uint32_t Buckets[BucketCount]{};
+	uint64_t Sum = 0;
+	uint32_t Count = 0;
+	uint32_t Min = UINT32_MAX;
+	uint32_t Max = 0;
+
+public:
+	void Clear()
+	{
+		for (uint8_t i = 0; i < BucketCount; i++)
+		{
+			Buckets[i] = 0;
+		}
+		Sum = 0;
+		Count = 0;
+		Min = UINT32_MAX;
+		Max = 0;
+	}
+
+	void Add(const uint32_t micros)
+	{
+		Buckets[GetBucket(micros)]++;
+		Sum += micros;
+		Count++;
+
+		if (micros < Min)
+		{
+			Min = micros;
+		}
+		if (micros > Max)
+		{
+			Max = micros;
+		}
+	}
+
+	void GetSummary(LatencySummaryStruct& summary) const
+	{
+		summary.Count = Count;
+		if (Count > 0)
+		{
+			summary.Min = Min;
+			summary.Average = Sum / Count;
+			summary.P99 = GetPercentile(99);
+			summary.Max = Max;
+		}
+		else
+		{
+			summary.Min = 0;
+			summary.Average = 0;
+			summary.P99 = 0;
+			summary.Max = 0;
+		}
+	}
+
+	/// <summary>
+	/// Upper bound of the bucket that contains the percentile.
+	/// </summary>
+	/// <param name="percent">[1 ; 100]</param>
+	const uint32_t GetPercentile(const uint8_t percent) const
+	{
+		const uint32_t target = (((uint64_t)Count * percent) + 99) / 100;
+		uint32_t accumulated = 0;
+
+		for (uint8_t i = 0; i < BucketCount; i++)
+		{
+			accumulated += Buckets[i];
+			if (accumulated >= target
+				&& accumulated > 0)
+			{
+				const uint32_t upper = GetBucketUpper(i);
+
+				return upper < Max ? upper : Max;
+			}
+		}
+
+		return Max;
+	}
+
+private:
+	static const uint8_t GetBucket(const uint32_t value)
+	{
+		if (value < SubSteps)
+		{
+			return value;
+		}
+
+		const uint8_t msb = 31 - __builtin_clz(value);
+		const uint8_t sub = (value >> (msb - SubBits)) & (SubSteps - 1);
+		const uint16_t bucket = ((uint16_t)(msb - SubBits + 1) * SubSteps) + sub;
+
+		return bucket < BucketCount ? bucket : (BucketCount - 1);
+	}
+
+	static const uint32_t GetBucketUpper(const uint8_t bucket)
+	{
+		if (bucket < SubSteps)
+		{
+			return bucket;
+		}
+
+		const uint8_t msb = (bucket / SubSteps) + SubBits - 1;
+		const uint8_t sub = bucket % SubSteps;
+
+		return ((((uint32_t)SubSteps + sub + 1) << (msb - SubBits))) - 1;
+	}
+};
+#endif
@@ -261,7 +261,12 @@ namespace RetroBle
 			/// <summary>
 			/// Custom device, Model M Keyboard.
 			/// </summary>
-			KeyboardModelM = (uint16_t)ProductBase::Custom - 1
+			KeyboardModelM = (uint16_t)ProductBase::Custom - 1,
+
+			/// <summary>
+			/// BLE controller host, bridged to USB HID.
+			/// </summary>
+			BleToUsbGamepad = (uint16_t)ProductBase::Custom - 2
 		};
 	}
 }
@@ -0,0 +1,74 @@
+// SpscMailbox.h
+
+#ifndef _SPSC_MAILBOX_h
+#define _SPSC_MAILBOX_h
+
+#include <stdint.h>
+#include <atomic>
+
+/// <summary>
+/// Lock-free single producer, single consumer latest-wins mailbox (triple buffer).
+/// The producer fills its slot in place and commits it, it never waits nor fails.
+/// An unread item is replaced by the next commit, the consumer always gets the newest one.
+/// No interrupt masking, slots are handed over with a single atomic exchange.
+/// </summary>
+/// <typeparam name="T">Trivially copyable item.</typeparam>
+template<typename T>
+class SpscMailbox
+{
+private:
+	static constexpr uint8_t IndexMask = 0x03;
+	static constexpr uint8_t FreshFlag = 0x80;
+
+private:
+	T Items[3]{};
+
+	/// <summary>
+	/// Slot in between producer and consumer, with the fresh flag.
+	/// </summary>
+	std::atomic<uint8_t> Middle{ 1 };
+
+	// Producer only.
+	uint8_t Back = 0;
+
+	// Consumer only.
+	uint8_t Front = 2;
+
+public:
+	/// <summary>
+	/// Producer: slot to fill, valid until Commit.
+	/// </summary>
+	T& Reserve()
+	{
+		return Items[Back];
+	}
+
+	/// <summary>
+	/// Producer: publish the reserved slot.
+	/// </summary>
+	/// <returns>False if an unread item was replaced.</returns>
+	const bool Commit()
+	{
+		const uint8_t previous = Middle.exchange(Back | FreshFlag, std::memory_order_acq_rel);
+		Back = previous & IndexMask;
+
+		return (previous & FreshFlag) == 0;
+	}
+
+	/// <summary>
+	/// Consumer: newest item, valid until the next Take.
+	/// </summary>
+	/// <returns>nullptr if nothing was committed since the last Take.</returns>
+	const T* Take()
+	{
+		if ((Middle.load(std::memory_order_relaxed) & FreshFlag) == 0)
+		{
+			return nullptr;
+		}
+
+		Front = Middle.exchange(Front, std::memory_order_acq_rel) & IndexMask;
+
+		return &Items[Front];
+	}
+};
+#endif
@@ -44,6 +44,9 @@ namespace RetroBle
 		BatteryManager::IBatteryManager* BMS;
 		HidBackReport::IListener* HidBackReportListener;
 
+	private:
+		const uint32_t ConnectedIdleTimeout;
+
 	private:
 		HidBatteryTask HidBattery;
 		BatteryManager::BatteryStateStruct BatteryState{};
@@ -57,7 +60,8 @@ namespace RetroBle
 			IHidDevice* hidMapper,
 			UsbPeripheral& usbDevice,
 			BlePeripheral& bleDevice,
-			HidBackReport::IListener* hidBackReportListener = nullptr)
+			HidBackReport::IListener* hidBackReportListener = nullptr,
+			const uint32_t connectedIdleTimeout = RetroBle::BleConfig::CONNECTED_NO_ACTIVITY_TIMEOUT_MILLIS)
 			: IBleListener()
 			, TS::Task(0, TASK_FOREVER, &scheduler, false)
 			, UsbDev(usbDevice)
@@ -67,6 +71,7 @@ namespace RetroBle
 			, BMS(bms)
 			, HidBattery(scheduler, bms, bleDevice)
 			, HidBackReportListener(hidBackReportListener)
+			, ConnectedIdleTimeout(connectedIdleTimeout)
 		{
 		}
 
@@ -165,12 +170,17 @@ namespace RetroBle
 						HidMapper->SetTarget(IHidDevice::TargetEnum::None);
 						State = StateEnum::PowerDown;
 					}
-					/*else if ((millis() - BleStart) > RetroBle::BleConfig::CONNECTED_NO_ACTIVITY_TIMEOUT_MILLIS
-						&& HidMapper->GetElapsedMillisSinceLastActivity() >= RetroBle::BleConfig::CONNECTED_NO_ACTIVITY_TIMEOUT_MILLIS)
+					else if (ConnectedIdleTimeout > 0
+						&& (millis() - BleStart) > ConnectedIdleTimeout
+						&& HidMapper->GetElapsedMillisSinceLastActivity() >= ConnectedIdleTimeout)
 					{
+						// No activity time-out.
+						HidBattery.Disable();
+						BleDev.Stop();
+						HidMapper->SetTarget(IHidDevice::TargetEnum::None);
 						State = StateEnum::Sleep;
 						TS::Task::delay(0);
-					}*/
+					}
 					else // No activity time-out or long press to shutdown.
 					{
 						BMS->GetBatteryState(BatteryState);
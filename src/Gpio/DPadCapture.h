@@ -0,0 +1,52 @@
+// DPadCapture.h
+
+#ifndef _DPAD_CAPTURE_h
+#define _DPAD_CAPTURE_h
+
+#include <stdint.h>
+#include <VirtualPad.h>
+
+namespace PortCapture
+{
+	/// <summary>
+	/// Direction bits of a captured D-Pad, active high.
+	/// </summary>
+	enum class DPadBit : uint8_t
+	{
+		Up = 0,
+		Down = 1,
+		Left = 2,
+		Right = 3
+	};
+
+	/// <summary>
+	/// Branch-free D-Pad decode, opposite directions cancel out.
+	/// </summary>
+	/// <param name="directions">Up | Down << 1 | Left << 2 | Right << 3.</param>
+	/// <returns></returns>
+	static VirtualPad::DPadEnum GetDPad(const uint8_t directions)
+	{
+		static constexpr VirtualPad::DPadEnum Lut[16] =
+		{
+			VirtualPad::DPadEnum::None,
+			VirtualPad::DPadEnum::Up,
+			VirtualPad::DPadEnum::Down,
+			VirtualPad::DPadEnum::None,
+			VirtualPad::DPadEnum::Left,
+			VirtualPad::DPadEnum::UpLeft,
+			VirtualPad::DPadEnum::DownLeft,
+			VirtualPad::DPadEnum::Left,
+			VirtualPad::DPadEnum::Right,
+			VirtualPad::DPadEnum::UpRight,
+			VirtualPad::DPadEnum::DownRight,
+			VirtualPad::DPadEnum::Right,
+			VirtualPad::DPadEnum::None,
+			VirtualPad::DPadEnum::Up,
+			VirtualPad::DPadEnum::Down,
+			VirtualPad::DPadEnum::None
+		};
+
+		return Lut[directions & 0x0F];
+	}
+}
+#endif
@@ -0,0 +1,109 @@
+// PortCapture.h
+
+#ifndef _PORT_CAPTURE_h
+#define _PORT_CAPTURE_h
+
+#if defined(ARDUINO_ARCH_NRF52)
+#include <Arduino.h>
+
+namespace PortCapture
+{
+	/// <summary>
+	/// nRF52 port pin index is Port * 32 + Bit.
+	/// </summary>
+	static constexpr uint8_t PortPinsPerPort = 32;
+
+	/// <summary>
+	/// Compile-time gather of port bits into a packed layout.
+	/// Bit Index of the result is the state of the Index-th pin in the list.
+	/// </summary>
+	/// <typeparam name="PortMap">Platform map with static constexpr uint8_t GetPortPin(const uint8_t pin).</typeparam>
+	/// <typeparam name="Index">Output bit of the first pin.</typeparam>
+	/// <typeparam name="...Pins">Arduino pin numbers.</typeparam>
+	template<typename PortMap, uint8_t Index, uint8_t... Pins>
+	struct Gather
+	{
+		static constexpr uint32_t MaskP0 = 0;
+		static constexpr uint32_t MaskP1 = 0;
+
+		static uint32_t Get(const uint32_t p0, const uint32_t p1)
+		{
+			return 0;
+		}
+	};
+
+	template<typename PortMap, uint8_t Index, uint8_t Pin, uint8_t... Pins>
+	struct Gather<PortMap, Index, Pin, Pins...>
+	{
+	private:
+		using Next = Gather<PortMap, Index + 1, Pins...>;
+
+		static constexpr uint8_t PortPin = PortMap::GetPortPin(Pin);
+		static constexpr uint8_t Port = PortPin / PortPinsPerPort;
+		static constexpr uint8_t Bit = PortPin % PortPinsPerPort;
+
+		static_assert(Index < 32, "Up to 32 pins per capture.");
+
+	public:
+		static constexpr uint32_t MaskP0 = ((Port == 0) ? ((uint32_t)1 << Bit) : 0) | Next::MaskP0;
+		static constexpr uint32_t MaskP1 = ((Port == 1) ? ((uint32_t)1 << Bit) : 0) | Next::MaskP1;
+
+		static uint32_t Get(const uint32_t p0, const uint32_t p1)
+		{
+			return ((((Port == 0 ? p0 : p1) >> Bit) & 1) << Index) | Next::Get(p0, p1);
+		}
+	};
+
+	/// <summary>
+	/// Single-read capture of a pin set.
+	/// Reads each used port IN register once and gathers the bits with constant masks and shifts.
+	/// </summary>
+	/// <typeparam name="PortMap">Platform map with static constexpr uint8_t GetPortPin(const uint8_t pin).</typeparam>
+	/// <typeparam name="...Pins">Arduino pin numbers, in output bit order.</typeparam>
+	template<typename PortMap, uint8_t... Pins>
+	struct Capture
+	{
+	private:
+		using Layout = Gather<PortMap, 0, Pins...>;
+
+	public:
+		/// <summary>
+		/// Raw pin states, bit i is the i-th pin in the list.
+		/// </summary>
+		static uint32_t Read()
+		{
+			const uint32_t p0 = (Layout::MaskP0 != 0) ? NRF_P0->IN : 0;
+			const uint32_t p1 = (Layout::MaskP1 != 0) ? NRF_P1->IN : 0;
+			return Layout::Get(p0, p1);
+		}
+	};
+
+	/// <summary>
+	/// Single register write output for a pin.
+	/// </summary>
+	/// <typeparam name="PortMap">Platform map with static constexpr uint8_t GetPortPin(const uint8_t pin).</typeparam>
+	/// <typeparam name="Pin">Arduino pin number.</typeparam>
+	template<typename PortMap, uint8_t Pin>
+	struct Output
+	{
+	private:
+		static constexpr uint8_t PortPin = PortMap::GetPortPin(Pin);
+		static constexpr uint32_t Mask = (uint32_t)1 << (PortPin % PortPinsPerPort);
+
+	public:
+		static void Set(const bool state)
+		{
+			NRF_GPIO_Type* port = (PortPin < PortPinsPerPort) ? NRF_P0 : NRF_P1;
+			if (state)
+			{
+				port->OUTSET = Mask;
+			}
+			else
+			{
+				port->OUTCLR = Mask;
+			}
+		}
+	};
+}
+#endif
+#endif
@@ -0,0 +1,183 @@
+// GamepadMapperTask.h
+
+#ifndef _GAMEPAD_MAPPER_TASK_h
+#define _GAMEPAD_MAPPER_TASK_h
+
+#if defined(_TASK_OO_CALLBACKS)
+#include <VirtualPad.h>
+
+#include "HidGamepadTask.h"
+#include "GamepadMapping.h"
+#include "GamepadRemap.h"
+
+/// <summary>
+/// Maps a VirtualPad source to the HID gamepad, with a compile-time mapping table.
+/// See GamepadMapping for the table layout.
+/// Optional user remap profiles are applied on top of the table, see GamepadRemap.
+/// The remap combo buttons are held back from the report from the moment the full combo is held, until all are released.
+/// The combo is only armed once a user profile is stored, see GamepadRemapConsole.
+/// </summary>
+/// <typeparam name="PadType">Sleep capable VirtualPad, with Read().</typeparam>
+/// <typeparam name="MappingTable">GamepadMapping table.</typeparam>
+/// <typeparam name="Debounce">DebounceProfile for the controller contacts.</typeparam>
+template<typename PadType,
+	typename MappingTable,
+	typename Debounce = DebounceNone>
+class GamepadMapperTask : public DebouncedHidGamepadTask<Debounce>
+{
+private:
+	using Buttons = typename MappingTable::Buttons;
+
+	static_assert(MappingTable::RemapCombo == 0
+		|| MappingTable::PowerDownHoldMillis == 0
+		|| (Buttons::GetTarget(MappingTable::PowerDownButton) & MappingTable::RemapCombo) == 0,
+		"Remap combo can't include the power down button.");
+
+private:
+	PadType& Source;
+	VirtualPad::ButtonParser::ActionTimed PowerDownHold{};
+	bool PowerDownRequested = false;
+
+private:
+	GamepadRemap Remap{ MappingTable::RemapProfileCount };
+	uint32_t RemapComboStart = 0;
+	bool RemapComboHeld = false;
+	bool RemapComboDone = false;
+
+public:
+	GamepadMapperTask(TS::Scheduler& scheduler,
+		PadType& padSource,
+		UsbHidGamepad& usbGamepad,
+		BLEHidGamepad& bleGamepad,
+		const uint32_t bleUpdatePeriod = 15)
+		: DebouncedHidGamepadTask<Debounce>(scheduler, usbGamepad, bleGamepad, bleUpdatePeriod)
+		, Source(padSource)
+	{
+	}
+
+	/// <summary>
+	/// Restore the user remap profile, after the file system is mounted.
+	/// </summary>
+	const bool SetupRemap()
+	{
+		return Remap.Setup();
+	}
+
+	/// <summary>
+	/// User remap profiles, to store new ones.
+	/// </summary>
+	GamepadRemap& GetRemap()
+	{
+		return Remap;
+	}
+
+public:
+	virtual bool IsPowerDownRequested() const final
+	{
+		return PowerDownRequested;
+	}
+
+	/// <summary>
+	/// Sleep peripheral and setup wake event.
+	/// </summary>
+	/// <returns>False if sleep isn't possible right now.</returns>
+	virtual bool WakeOnInterrupt() final
+	{
+		return Source.WakeOnInterrupt();
+	}
+
+	/// <summary>
+	/// Device has just woken up from sleep, restore peripheral.
+	/// </summary>
+	virtual void OnWakeUp() final
+	{
+		PowerDownHold.Clear();
+		PowerDownRequested = false;
+		Source.Read();
+		Source.OnWakeUp();
+	}
+
+protected:
+	virtual void UpdateState(hid_gamepad_report_t& hidReport) final
+	{
+		Source.Read();
+
+		if (MappingTable::PowerDownHoldMillis > 0)
+		{
+			PowerDownHold.Parse(millis(), GamepadMapping::SourceButton<MappingTable::PowerDownButton>::Get(Source));
+			PowerDownRequested = PowerDownHold.ActionDown(uint32_t(MappingTable::PowerDownHoldMillis));
+		}
+
+		uint32_t buttons = Buttons::Get(Source);
+
+		// Without stored profiles the combo has nothing to cycle, the buttons go through.
+		if (MappingTable::RemapCombo != 0
+			&& Remap.HasProfiles()
+			&& UpdateRemapCombo(buttons))
+		{
+			buttons &= ~MappingTable::RemapCombo;
+		}
+
+		hidReport.buttons = Remap.Apply(buttons);
+		hidReport.hat = GetHat((uint8_t)Source.DPad());
+	}
+
+private:
+	/// <summary>
+	/// Holding the combo cycles to the next remap profile, once per hold.
+	/// The combo stays armed until all its buttons are released, a partial release restarts the hold.
+	/// File access only happens here, on switch.
+	/// </summary>
+	/// <returns>True while the combo is armed.</returns>
+	const bool UpdateRemapCombo(const uint32_t buttons)
+	{
+		const uint32_t held = buttons & MappingTable::RemapCombo;
+
+		if (held == 0)
+		{
+			RemapComboHeld = false;
+			RemapComboDone = false;
+		}
+		else if (held != MappingTable::RemapCombo)
+		{
+			RemapComboStart = millis();
+		}
+		else if (!RemapComboHeld)
+		{
+			RemapComboHeld = true;
+			RemapComboStart = millis();
+		}
+		else if (!RemapComboDone
+			&& ((millis() - RemapComboStart) >= MappingTable::RemapHoldMillis))
+		{
+			RemapComboDone = true;
+			Remap.NextProfile();
+#if defined(DEBUG)
+			Serial.print(F("Remap profile "));
+			Serial.println(Remap.GetProfile());
+#endif
+		}
+
+		return RemapComboHeld;
+	}
+
+	static const uint8_t GetHat(const uint8_t dPad)
+	{
+		static constexpr uint8_t Lut[GAMEPAD_HAT_UP_LEFT + 1] =
+		{
+			MappingTable::MapHat(0),
+			MappingTable::MapHat(1),
+			MappingTable::MapHat(2),
+			MappingTable::MapHat(3),
+			MappingTable::MapHat(4),
+			MappingTable::MapHat(5),
+			MappingTable::MapHat(6),
+			MappingTable::MapHat(7),
+			MappingTable::MapHat(8)
+		};
+
+		return (dPad <= GAMEPAD_HAT_UP_LEFT) ? Lut[dPad] : GAMEPAD_HAT_CENTERED;
+	}
+};
+#endif
+#endif
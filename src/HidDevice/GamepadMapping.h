@@ -0,0 +1,147 @@
+// GamepadMapping.h
+
+#ifndef _GAMEPAD_MAPPING_h
+#define _GAMEPAD_MAPPING_h
+
+#include <stdint.h>
+#include <bluefruit.h>
+#include <VirtualPad.h>
+
+/// <summary>
+/// Compile-time VirtualPad to HID gamepad mapping tables.
+/// A mapping table is a struct with:
+///		Buttons - ButtonTable of Map entries, VirtualPad source to GAMEPAD_BUTTON_* target.
+///		MapHat - constexpr DPad to GAMEPAD_HAT_* mapping, expanded into a 9 entry lookup table.
+///		PowerDownButton/PowerDownHoldMillis - Long press to power down, 0 to disable.
+///		RemapProfileCount/RemapCombo/RemapHoldMillis - User remap profiles, cycled by holding the combo (HID buttons), 0 to disable.
+/// Inherit from Table for the defaults.
+/// </summary>
+namespace GamepadMapping
+{
+	/// <summary>
+	/// VirtualPad button sources.
+	/// </summary>
+	enum class SourceEnum : uint8_t
+	{
+		A,
+		B,
+		X,
+		Y,
+		L1,
+		R1,
+		L2,
+		R2,
+		L3,
+		R3,
+		Start,
+		Select,
+		Home,
+		Share
+	};
+
+	/// <summary>
+	/// Single VirtualPad button read, resolved at compile time.
+	/// </summary>
+	template<SourceEnum Source>
+	struct SourceButton;
+
+	template<> struct SourceButton<SourceEnum::A> { template<typename Pad> static const bool Get(Pad& pad) { return pad.A(); } };
+	template<> struct SourceButton<SourceEnum::B> { template<typename Pad> static const bool Get(Pad& pad) { return pad.B(); } };
+	template<> struct SourceButton<SourceEnum::X> { template<typename Pad> static const bool Get(Pad& pad) { return pad.X(); } };
+	template<> struct SourceButton<SourceEnum::Y> { template<typename Pad> static const bool Get(Pad& pad) { return pad.Y(); } };
+	template<> struct SourceButton<SourceEnum::L1> { template<typename Pad> static const bool Get(Pad& pad) { return pad.L1(); } };
+	template<> struct SourceButton<SourceEnum::R1> { template<typename Pad> static const bool Get(Pad& pad) { return pad.R1(); } };
+	template<> struct SourceButton<SourceEnum::L2> { template<typename Pad> static const bool Get(Pad& pad) { return pad.L2() > 0; } };
+	template<> struct SourceButton<SourceEnum::R2> { template<typename Pad> static const bool Get(Pad& pad) { return pad.R2() > 0; } };
+	template<> struct SourceButton<SourceEnum::L3> { template<typename Pad> static const bool Get(Pad& pad) { return pad.L3(); } };
+	template<> struct SourceButton<SourceEnum::R3> { template<typename Pad> static const bool Get(Pad& pad) { return pad.R3(); } };
+	template<> struct SourceButton<SourceEnum::Start> { template<typename Pad> static const bool Get(Pad& pad) { return pad.Start(); } };
+	template<> struct SourceButton<SourceEnum::Select> { template<typename Pad> static const bool Get(Pad& pad) { return pad.Select(); } };
+	template<> struct SourceButton<SourceEnum::Home> { template<typename Pad> static const bool Get(Pad& pad) { return pad.Home(); } };
+	template<> struct SourceButton<SourceEnum::Share> { template<typename Pad> static const bool Get(Pad& pad) { return pad.Share(); } };
+
+	/// <summary>
+	/// Mapping table entry.
+	/// </summary>
+	/// <typeparam name="Source">VirtualPad source.</typeparam>
+	/// <typeparam name="TargetMask">GAMEPAD_BUTTON_* target.</typeparam>
+	template<SourceEnum Source, uint32_t TargetMask>
+	struct Map
+	{
+		static_assert(TargetMask != 0 && (TargetMask & (TargetMask - 1)) == 0, "Target must be a single button.");
+
+		template<typename Pad>
+		static const uint32_t Get(Pad& pad)
+		{
+			// Branch-free, bool times a power of 2 is a shift.
+			return TargetMask * (uint32_t)SourceButton<Source>::Get(pad);
+		}
+
+		static constexpr uint32_t GetTarget(const SourceEnum source)
+		{
+			return source == Source ? TargetMask : 0;
+		}
+	};
+
+	/// <summary>
+	/// Button permutation, unrolled at compile time into a straight sequence of reads, shifts and ORs.
+	/// Only the mapped sources are read.
+	/// </summary>
+	template<typename... Maps>
+	struct ButtonTable;
+
+	template<>
+	struct ButtonTable<>
+	{
+		template<typename Pad>
+		static const uint32_t Get(Pad& pad)
+		{
+			return 0;
+		}
+
+		static constexpr uint32_t GetTarget(const SourceEnum source)
+		{
+			return 0;
+		}
+	};
+
+	template<typename Head, typename... Tail>
+	struct ButtonTable<Head, Tail...>
+	{
+		template<typename Pad>
+		static const uint32_t Get(Pad& pad)
+		{
+			return Head::Get(pad) | ButtonTable<Tail...>::Get(pad);
+		}
+
+		/// <summary>
+		/// GAMEPAD_BUTTON_* target(s) of a source, 0 if unmapped.
+		/// </summary>
+		static constexpr uint32_t GetTarget(const SourceEnum source)
+		{
+			return Head::GetTarget(source) | ButtonTable<Tail...>::GetTarget(source);
+		}
+	};
+
+	/// <summary>
+	/// Table defaults: no buttons, identity hat, no power down.
+	/// VirtualPad DPadEnum is derived from HID DPad, so the identity is a direct match.
+	/// </summary>
+	struct Table
+	{
+		using Buttons = ButtonTable<>;
+
+		static constexpr uint8_t MapHat(const uint8_t dPad)
+		{
+			return dPad <= GAMEPAD_HAT_UP_LEFT ? dPad : GAMEPAD_HAT_CENTERED;
+		}
+
+		static constexpr SourceEnum PowerDownButton = SourceEnum::Start;
+		static constexpr uint32_t PowerDownHoldMillis = 0;
+
+		static constexpr uint8_t RemapProfileCount = 0;
+		static constexpr uint32_t RemapCombo = 0;
+		static constexpr uint32_t RemapHoldMillis = 2000;
+	};
+}
+#endif
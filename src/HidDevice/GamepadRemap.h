@@ -0,0 +1,332 @@
+// GamepadRemap.h
+
+#ifndef _GAMEPAD_REMAP_h
+#define _GAMEPAD_REMAP_h
+
+#if defined(ARDUINO_ARCH_NRF52)
+#include <Adafruit_LittleFS.h>
+#include <InternalFileSystem.h>
+
+#include "../Framework/InternalFile.h"
+
+/// <summary>
+/// Single remap entry, in HID report button bits [0 ; 31].
+/// </summary>
+struct RemapEntryStruct
+{
+	uint8_t Source;
+
+	/// <summary>
+	/// Target button bit, UINT8_MAX to disable the source.
+	/// </summary>
+	uint8_t Target;
+};
+
+/// <summary>
+/// User button remap profiles, persisted in the internal file system.
+/// Profile 0 is the identity, profiles [1 ; ProfileCount-1] are stored as a list of entries.
+/// The active profile is compiled on load into a flat 32 entry table of target masks,
+/// so applying it costs one lookup per pressed button, with no file access.
+/// Unlisted buttons keep their position.
+/// Profiles are authored at runtime with SaveProfile(), see GamepadRemapConsole.
+/// </summary>
+class GamepadRemap
+{
+public:
+	static constexpr uint8_t ButtonCount = 32;
+	static constexpr uint8_t MaxEntries = ButtonCount;
+
+private:
+	static constexpr uint8_t FormatVersion = 1;
+	static constexpr uint8_t PathSize = sizeof("/remap/0");
+
+	struct ProfileHeaderStruct
+	{
+		uint8_t Version;
+		uint8_t Count;
+	};
+
+private:
+	uint32_t Table[ButtonCount]{};
+	const uint8_t ProfileCount;
+	uint8_t Profile = 0;
+	bool Identity = true;
+
+	/// <summary>
+	/// Stored profile slots, bit per profile.
+	/// </summary>
+	uint16_t Stored = 0;
+
+public:
+	GamepadRemap(const uint8_t profileCount)
+		: ProfileCount(profileCount <= 10 ? profileCount : 10) // Single digit file names.
+	{}
+
+	/// <summary>
+	/// Restore the last selected profile.
+	/// Call after Bluefruit.begin(), which mounts the file system.
+	/// </summary>
+	/// <returns>False if the file system isn't available, identity is used.</returns>
+	const bool Setup()
+	{
+		if (ProfileCount < 2
+			|| !InternalFS.begin())
+		{
+			SetIdentity();
+			return false;
+		}
+
+		if (!InternalFS.exists("/remap"))
+		{
+			InternalFS.mkdir("/remap");
+		}
+
+		Stored = 0;
+		for (uint8_t profile = 1; profile < ProfileCount; profile++)
+		{
+			char path[PathSize];
+			GetProfilePath(path, profile);
+			if (InternalFS.exists(path))
+			{
+				Stored |= (uint16_t)1 << profile;
+			}
+		}
+
+		uint8_t profile = 0;
+		if (!InternalFile::Read("/remap/active", &profile, sizeof(profile))
+			|| !Load(profile))
+		{
+			SetIdentity();
+		}
+
+		return true;
+	}
+
+	const uint8_t GetProfile() const
+	{
+		return Profile;
+	}
+
+	const uint8_t GetProfileCount() const
+	{
+		return ProfileCount;
+	}
+
+	/// <summary>
+	/// At least one user profile is stored, otherwise there's nothing to cycle.
+	/// </summary>
+	const bool HasProfiles() const
+	{
+		return Stored != 0;
+	}
+
+	const bool IsStored(const uint8_t profile) const
+	{
+		return profile < ProfileCount
+			&& ((Stored >> profile) & 1);
+	}
+
+	/// <summary>
+	/// Remap the report buttons.
+	/// One table lookup per pressed button, so the cost grows with the pressed count, up to ButtonCount lookups.
+	/// </summary>
+	const uint32_t Apply(const uint32_t buttons) const
+	{
+		if (Identity)
+		{
+			return buttons;
+		}
+
+		uint32_t mapped = 0;
+		uint32_t pending = buttons;
+		while (pending != 0)
+		{
+			mapped |= Table[__builtin_ctz(pending)];
+			pending &= pending - 1;
+		}
+
+		return mapped;
+	}
+
+	/// <summary>
+	/// Cycle to the next profile, skipping empty slots.
+	/// </summary>
+	/// <returns>True if the profile changed.</returns>
+	const bool NextProfile()
+	{
+		for (uint8_t i = 1; i < ProfileCount; i++)
+		{
+			const uint8_t profile = (Profile + i) % ProfileCount;
+			if (SelectProfile(profile))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Load and persist the selected profile.
+	/// </summary>
+	/// <param name="profile">[0 ; ProfileCount-1]</param>
+	/// <returns>False if the profile is empty or invalid, the active profile is kept.</returns>
+	const bool SelectProfile(const uint8_t profile)
+	{
+		if (!Load(profile))
+		{
+			return false;
+		}
+
+		InternalFile::Write("/remap/active", &profile, sizeof(profile));
+
+		return true;
+	}
+
+	/// <summary>
+	/// Store a profile, the active profile is reloaded if overwritten.
+	/// </summary>
+	/// <param name="profile">[1 ; ProfileCount-1]</param>
+	/// <param name="entries"></param>
+	/// <param name="count">[0 ; MaxEntries], 0 deletes the profile.</param>
+	const bool SaveProfile(const uint8_t profile, const RemapEntryStruct* entries, const uint8_t count)
+	{
+		if (profile == 0
+			|| profile >= ProfileCount
+			|| count > MaxEntries
+			|| !IsValid(entries, count))
+		{
+			return false;
+		}
+
+		char path[PathSize];
+		GetProfilePath(path, profile);
+
+		if (count == 0)
+		{
+			InternalFS.remove(path);
+			Stored &= ~((uint16_t)1 << profile);
+		}
+		else
+		{
+			uint8_t buffer[sizeof(ProfileHeaderStruct) + (MaxEntries * sizeof(RemapEntryStruct))];
+			const ProfileHeaderStruct header{ FormatVersion, count };
+			memcpy(buffer, &header, sizeof(header));
+			memcpy(&buffer[sizeof(header)], entries, count * sizeof(RemapEntryStruct));
+
+			if (!InternalFile::Write(path, buffer, sizeof(header) + (count * sizeof(RemapEntryStruct))))
+			{
+				return false;
+			}
+			Stored |= (uint16_t)1 << profile;
+		}
+
+		if (profile == Profile
+			&& !Load(profile))
+		{
+			SetIdentity();
+		}
+
+		return true;
+	}
+
+private:
+	static void GetProfilePath(char (&path)[PathSize], const uint8_t profile)
+	{
+		memcpy(path, "/remap/0", PathSize);
+		path[PathSize - 2] = '0' + profile;
+	}
+
+	/// <summary>
+	/// Read the profile and compile its table.
+	/// </summary>
+	const bool Load(const uint8_t profile)
+	{
+		if (profile == 0)
+		{
+			SetIdentity();
+			return true;
+		}
+		else if (profile >= ProfileCount)
+		{
+			return false;
+		}
+
+		char path[PathSize];
+		GetProfilePath(path, profile);
+
+		uint8_t buffer[sizeof(ProfileHeaderStruct) + (MaxEntries * sizeof(RemapEntryStruct))];
+		const uint16_t size = InternalFile::Read(path, buffer, sizeof(buffer));
+
+		ProfileHeaderStruct header{};
+		if (size < sizeof(header))
+		{
+			return false;
+		}
+		memcpy(&header, buffer, sizeof(header));
+
+		RemapEntryStruct entries[MaxEntries];
+		if (header.Version != FormatVersion
+			|| header.Count > MaxEntries
+			|| size != (sizeof(header) + (header.Count * sizeof(RemapEntryStruct))))
+		{
+			return false;
+		}
+		memcpy(entries, &buffer[sizeof(header)], header.Count * sizeof(RemapEntryStruct));
+
+		if (!IsValid(entries, header.Count))
+		{
+			return false;
+		}
+
+		Compile(entries, header.Count);
+		Profile = profile;
+
+		return true;
+	}
+
+	void Compile(const RemapEntryStruct* entries, const uint8_t count)
+	{
+		for (uint8_t i = 0; i < ButtonCount; i++)
+		{
+			Table[i] = (uint32_t)1 << i;
+		}
+
+		for (uint8_t i = 0; i < count; i++)
+		{
+			Table[entries[i].Source] = (entries[i].Target < ButtonCount) ? ((uint32_t)1 << entries[i].Target) : 0;
+		}
+
+		Identity = true;
+		for (uint8_t i = 0; i < ButtonCount; i++)
+		{
+			if (Table[i] != ((uint32_t)1 << i))
+			{
+				Identity = false;
+				break;
+			}
+		}
+	}
+
+	void SetIdentity()
+	{
+		Profile = 0;
+		Identity = true;
+	}
+
+	static const bool IsValid(const RemapEntryStruct* entries, const uint8_t count)
+	{
+		for (uint8_t i = 0; i < count; i++)
+		{
+			if (entries[i].Source >= ButtonCount
+				|| (entries[i].Target >= ButtonCount && entries[i].Target != UINT8_MAX))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
+#endif
+#endif
@@ -0,0 +1,254 @@
+// GamepadRemapConsole.h
+
+#ifndef _GAMEPAD_REMAP_CONSOLE_h
+#define _GAMEPAD_REMAP_CONSOLE_h
+
+#if defined(_TASK_OO_CALLBACKS) && defined(ARDUINO_ARCH_NRF52)
+#include <Arduino.h>
+#include <TSchedulerDeclarations.hpp>
+
+#include "GamepadRemap.h"
+
+/// <summary>
+/// Line based serial commands to author the user remap profiles.
+///		remap list - Stored profiles and the active one.
+///		remap save <profile> <source>:<target> ... - Store a profile, buttons in HID bits [0 ; 31], target x disables the source.
+///		remap delete <profile>
+///		remap select <profile>
+/// Replies "ok" or "error".
+/// Runs on the same scheduler as the mapper, so the remap table is never swapped under a report.
+/// </summary>
+class GamepadRemapConsole : private TS::Task
+{
+private:
+	static constexpr uint8_t LineSize = 8 + (GamepadRemap::MaxEntries * 6);
+
+private:
+	Stream& Port;
+	GamepadRemap& Remap;
+
+private:
+	char Line[LineSize]{};
+	uint8_t LineLength = 0;
+	bool Overflow = false;
+
+public:
+	GamepadRemapConsole(TS::Scheduler& scheduler,
+		Stream& port,
+		GamepadRemap& remap,
+		const uint32_t updatePeriod = 50)
+		: TS::Task(updatePeriod, TASK_FOREVER, &scheduler, false)
+		, Port(port)
+		, Remap(remap)
+	{
+	}
+
+	void Start()
+	{
+		TS::Task::enable();
+	}
+
+	void Stop()
+	{
+		TS::Task::disable();
+	}
+
+	virtual bool Callback() final
+	{
+		while (Port.available() > 0)
+		{
+			const char value = (char)Port.read();
+
+			if (value == '\n' || value == '\r')
+			{
+				if (LineLength > 0 && !Overflow)
+				{
+					Line[LineLength] = '\0';
+					Reply(Execute());
+				}
+				else if (Overflow)
+				{
+					Reply(false);
+				}
+				LineLength = 0;
+				Overflow = false;
+			}
+			else if (LineLength < (LineSize - 1))
+			{
+				Line[LineLength++] = value;
+			}
+			else
+			{
+				Overflow = true;
+			}
+		}
+
+		return true;
+	}
+
+private:
+	void Reply(const bool success)
+	{
+		Port.println(success ? "ok" : "error");
+	}
+
+	const bool Execute()
+	{
+		const char* cursor = Line;
+		if (!Match(cursor, "remap"))
+		{
+			return false;
+		}
+
+		uint8_t profile = 0;
+		if (Match(cursor, "list"))
+		{
+			return List();
+		}
+		else if (Match(cursor, "select"))
+		{
+			return ParseNumber(cursor, profile)
+				&& AtEnd(cursor)
+				&& Remap.SelectProfile(profile);
+		}
+		else if (Match(cursor, "delete"))
+		{
+			return ParseNumber(cursor, profile)
+				&& AtEnd(cursor)
+				&& profile != 0
+				&& Remap.SaveProfile(profile, nullptr, 0);
+		}
+		else if (Match(cursor, "save"))
+		{
+			if (!ParseNumber(cursor, profile))
+			{
+				return false;
+			}
+
+			RemapEntryStruct entries[GamepadRemap::MaxEntries];
+			uint8_t count = 0;
+			while (!AtEnd(cursor))
+			{
+				if (count >= GamepadRemap::MaxEntries
+					|| !ParseEntry(cursor, entries[count]))
+				{
+					return false;
+				}
+				count++;
+			}
+
+			// An empty save would delete the profile.
+			return count > 0
+				&& Remap.SaveProfile(profile, entries, count);
+		}
+
+		return false;
+	}
+
+	const bool List()
+	{
+		Port.print("active ");
+		Port.println((uint32_t)Remap.GetProfile());
+		Port.print("stored");
+		for (uint8_t profile = 1; profile < Remap.GetProfileCount(); profile++)
+		{
+			if (Remap.IsStored(profile))
+			{
+				Port.print(' ');
+				Port.print((uint32_t)profile);
+			}
+		}
+		Port.println();
+
+		return true;
+	}
+
+	static void SkipSpaces(const char*& cursor)
+	{
+		while (*cursor == ' ' || *cursor == '\t')
+		{
+			cursor++;
+		}
+	}
+
+	static const bool AtEnd(const char*& cursor)
+	{
+		SkipSpaces(cursor);
+
+		return *cursor == '\0';
+	}
+
+	/// <summary>
+	/// Consume a whole word.
+	/// </summary>
+	static const bool Match(const char*& cursor, const char* word)
+	{
+		SkipSpaces(cursor);
+
+		const char* read = cursor;
+		while (*word != '\0')
+		{
+			if (*read++ != *word++)
+			{
+				return false;
+			}
+		}
+
+		if (*read != '\0' && *read != ' ' && *read != '\t')
+		{
+			return false;
+		}
+		cursor = read;
+
+		return true;
+	}
+
+	static const bool ParseNumber(const char*& cursor, uint8_t& value)
+	{
+		SkipSpaces(cursor);
+
+		if (*cursor < '0' || *cursor > '9')
+		{
+			return false;
+		}
+
+		uint16_t number = 0;
+		while (*cursor >= '0' && *cursor <= '9')
+		{
+			number = (number * 10) + (*cursor++ - '0');
+			if (number > UINT8_MAX)
+			{
+				return false;
+			}
+		}
+		value = (uint8_t)number;
+
+		return true;
+	}
+
+	/// <summary>
+	/// source:target, range checks are left to GamepadRemap.
+	/// </summary>
+	static const bool ParseEntry(const char*& cursor, RemapEntryStruct& entry)
+	{
+		if (!ParseNumber(cursor, entry.Source)
+			|| *cursor++ != ':')
+		{
+			return false;
+		}
+
+		if (*cursor == 'x')
+		{
+			cursor++;
+			entry.Target = UINT8_MAX;
+		}
+		else if (!ParseNumber(cursor, entry.Target))
+		{
+			return false;
+		}
+
+		return *cursor == '\0' || *cursor == ' ' || *cursor == '\t';
+	}
+};
+#endif
+#endif
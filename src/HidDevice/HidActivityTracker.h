@@ -0,0 +1,103 @@
+// HidActivityTracker.h
+
+#ifndef _HID_ACTIVITY_TRACKER_h
+#define _HID_ACTIVITY_TRACKER_h
+
+#include <stdint.h>
+#include <bluefruit.h>
+
+/// <summary>
+/// Activity counters.
+/// </summary>
+struct HidActivityStatsStruct
+{
+	/// <summary>
+	/// Samples with a button or hat change.
+	/// </summary>
+	uint32_t Digital = 0;
+
+	/// <summary>
+	/// Samples with an axis moved beyond the deadband.
+	/// </summary>
+	uint32_t Analog = 0;
+};
+
+/// <summary>
+/// Incremental gamepad activity detection, updated on every sample.
+/// Buttons and hat count on any change.
+/// Axes count when they move beyond the deadband from where they last counted,
+/// so sensor noise and slow drift of a resting stick don't keep the device awake.
+/// </summary>
+class HidActivityTracker
+{
+private:
+	hid_gamepad_report_t Reference{};
+	HidActivityStatsStruct Stats{};
+	uint8_t Deadband;
+
+public:
+	HidActivityTracker(const uint8_t deadband)
+		: Deadband(deadband)
+	{}
+
+	void SetDeadband(const uint8_t deadband)
+	{
+		Deadband = deadband;
+	}
+
+	/// <summary>
+	/// </summary>
+	/// <param name="sample">Latest input sample.</param>
+	/// <returns>True if the sample has user activity.</returns>
+	const bool Step(const hid_gamepad_report_t& sample)
+	{
+		bool active = false;
+
+		if (sample.buttons != Reference.buttons
+			|| sample.hat != Reference.hat)
+		{
+			Reference.buttons = sample.buttons;
+			Reference.hat = sample.hat;
+			Stats.Digital++;
+			active = true;
+		}
+
+		if (IsBeyond(sample.x, Reference.x)
+			|| IsBeyond(sample.y, Reference.y)
+			|| IsBeyond(sample.z, Reference.z)
+			|| IsBeyond(sample.rz, Reference.rz)
+			|| IsBeyond(sample.rx, Reference.rx)
+			|| IsBeyond(sample.ry, Reference.ry))
+		{
+			Reference.x = sample.x;
+			Reference.y = sample.y;
+			Reference.z = sample.z;
+			Reference.rz = sample.rz;
+			Reference.rx = sample.rx;
+			Reference.ry = sample.ry;
+			Stats.Analog++;
+			active = true;
+		}
+
+		return active;
+	}
+
+	void GetStats(HidActivityStatsStruct& stats) const
+	{
+		stats = Stats;
+	}
+
+	void ClearStats()
+	{
+		Stats = {};
+	}
+
+private:
+	const bool IsBeyond(const int8_t value, const int8_t reference) const
+	{
+		const int16_t delta = (int16_t)value - reference;
+
+		return delta > Deadband || delta < -(int16_t)Deadband;
+	}
+};
+#endif
@@ -0,0 +1,64 @@
+// HidGamepadLatch.h
+
+#ifndef _HID_GAMEPAD_LATCH_h
+#define _HID_GAMEPAD_LATCH_h
+
+#include <stdint.h>
+#include <bluefruit.h>
+
+/// <summary>
+/// Tap-preserving latch between the input samples and the outgoing HID report.
+/// Records every press edge seen between reports, so a press released before the next report still shows up in it.
+/// Held inputs pass through unchanged, releases of held inputs are not delayed.
+/// </summary>
+class HidGamepadLatch
+{
+private:
+	uint32_t PreviousButtons = 0;
+	uint32_t Taps = 0;
+
+	uint8_t PreviousHat = GAMEPAD_HAT_CENTERED;
+	uint8_t TapHat = GAMEPAD_HAT_CENTERED;
+
+public:
+	/// <summary>
+	/// Latch any press edges in the new sample.
+	/// </summary>
+	/// <param name="sample"></param>
+	void Step(const hid_gamepad_report_t& sample)
+	{
+		Taps |= sample.buttons & ~PreviousButtons;
+		PreviousButtons = sample.buttons;
+
+		if (sample.hat != PreviousHat
+			&& sample.hat != GAMEPAD_HAT_CENTERED)
+		{
+			TapHat = sample.hat;
+		}
+		PreviousHat = sample.hat;
+	}
+
+	/// <summary>
+	/// Add the latched taps to the report, on top of the current state.
+	/// </summary>
+	/// <param name="report">Report populated with the latest sample.</param>
+	void Merge(hid_gamepad_report_t& report) const
+	{
+		report.buttons |= Taps;
+
+		if (report.hat == GAMEPAD_HAT_CENTERED)
+		{
+			report.hat = TapHat;
+		}
+	}
+
+	/// <summary>
+	/// Latched taps have been delivered.
+	/// </summary>
+	void Clear()
+	{
+		Taps = 0;
+		TapHat = GAMEPAD_HAT_CENTERED;
+	}
+};
+#endif
@@ -3,24 +3,59 @@
 
 #if defined(_TASK_OO_CALLBACKS)
 #include <TSchedulerDeclarations.hpp>
+#include <atomic>
 
 #include <Adafruit_LittleFS.h>
 #include <InternalFileSystem.h>
 #include <bluefruit.h>
 
+#include "../Ble/BleConfig.h"
+#include "../Ble/IBleListener.h"
+#include "../Ble/BleRadioSync.h"
+#include "../Ble/BleTxOrder.h"
 #include "../Usb/UsbHidGamepad.h"
+#include "../Usb/UsbSofSync.h"
 #include "../BatteryManager/ISleep.h"
+#include "../Input/VerticalDebounce.h"
 #include "IHidDevice.h"
+#include "HidGamepadLatch.h"
+#include "HidLatencyProbe.h"
+#include "HidPollRate.h"
+#include "HidActivityTracker.h"
+
+/// <summary>
+/// Report emission counters, to check the airtime saved by change-driven reporting.
+/// </summary>
+struct HidReportStatsStruct
+{
+	/// <summary>
+	/// Reports handed over to the USB/BLE stack.
+	/// </summary>
+	uint32_t Sent = 0;
+
+	/// <summary>
+	/// Report opportunities skipped because nothing changed.
+	/// </summary>
+	uint32_t Suppressed = 0;
+};
 
 /// <summary>
 /// Abstract task for Gamepad HID reporting, with fixed period update.
 /// Combined HID reporting, for BLE or USB Gamepad.
+/// Reports are only emitted on change, on target switch or on the optional heartbeat period.
+/// Input is sampled at a sub-period rate and latched, so short presses always reach at least one report.
+/// Sampling slows down through the idle tiers while nothing changes, and snaps back on the next edge or wake interrupt.
+/// The wake interrupt only raises a flag, polled by the task between idle samples.
 /// Must implement ISleep interface for power life-cycle.
 /// Must implement virtual methods.
 ///		UpdateState - Update controller state and populate HID report.
 ///		IsPowerDownRequested - Controller has requested device to power down.
+/// UpdateState output goes through DebounceSample before reporting, pass-through here, see DebouncedHidGamepadTask.
+/// With a BleRadioSync, BLE reports are aligned to the radio notification instead, once per connection event.
+/// With a UsbSofSync, USB sampling is woken by the start-of-frame just before each endpoint poll.
+/// The start-of-frame only raises an atomic flag, polled on every scheduler pass while waiting for it.
 /// </summary>
-class HidGamepadTask : public virtual IHidDevice, private TS::Task
+class HidGamepadTask : public virtual IHidDevice, public virtual IBleTxListener, public virtual IUsbSofListener, private TS::Task
 {
 private:
 	UsbHidGamepad& UsbGamepad;
@@ -28,18 +63,50 @@ private:
 
 private:
 	const uint32_t BlePeriod;
+	const uint32_t HeartbeatPeriod;
+	const uint32_t SamplePeriod;
 
 private:
+	HidGamepadLatch Latch{};
+	hid_gamepad_report_t SampleReport{};
 	hid_gamepad_report_t HidReport{};
 	hid_gamepad_report_t LastHidReport{};
+	hid_gamepad_report_t LastSentReport{};
+
+private:
+	HidReportStatsStruct ReportStats{};
+	HidLatency::Probe Latency{};
+	BleTxOrder BleTx{};
+	uint32_t LastSent = 0;
+	uint32_t LastEmit = 0;
+	bool EmitNow = false;
+	bool ForceReport = true;
 
 private:
+	HidPollRate PollRate{};
+	HidActivityTracker Activity{ RetroBle::BleConfig::ACTIVITY_ANALOG_DEADBAND };
 	uint32_t LastActivity = 0;
+	uint32_t SampleDelayStart = 0;
+	uint32_t SampleDelay = 0;
+	volatile bool WakeEdge = false;
 	TargetEnum Target = TargetEnum::None;
 
+private:
+	const BleRadioSync* RadioSync = nullptr;
+	uint32_t RadioCount = 0;
+
+	UsbSofSync* UsbSync = nullptr;
+	std::atomic<bool> UsbSampleDue{ false };
+	bool UsbWaiting = false;
+
 protected:
 	virtual void UpdateState(hid_gamepad_report_t& hidReport) {}
 
+	/// <summary>
+	/// Filter the sampled buttons and hat in place, before they are latched.
+	/// </summary>
+	virtual void DebounceSample(hid_gamepad_report_t& sample) {}
+
 	/// <summary>
 	/// ISleep interface.
 	/// </summary>
@@ -57,51 +124,156 @@ public:
 	HidGamepadTask(TS::Scheduler& scheduler,
 		UsbHidGamepad& usbGamepad,
 		BLEHidGamepad& bleGamepad,
-		const uint32_t bleUpdatePeriod)
+		const uint32_t bleUpdatePeriod,
+		const uint32_t heartbeatPeriod = RetroBle::BleConfig::REPORT_HEARTBEAT_PERIOD_MILLIS,
+		const uint32_t samplePeriod = RetroBle::BleConfig::INPUT_SAMPLE_PERIOD_MILLIS)
 		: IHidDevice()
 		, TS::Task(TASK_IMMEDIATE, TASK_FOREVER, &scheduler, false)
 		, UsbGamepad(usbGamepad)
 		, BleGamepad(bleGamepad)
 		, BlePeriod(bleUpdatePeriod)
+		, HeartbeatPeriod(heartbeatPeriod)
+		, SamplePeriod((samplePeriod > 0 && samplePeriod < bleUpdatePeriod) ? samplePeriod : bleUpdatePeriod)
 	{}
 
+	/// <summary>
+	/// Input edge interrupt: sampled on the next wake poll, without waiting out the idle tier,
+	/// and reported without waiting for the period.
+	/// Only raises the flag, the scheduler isn't interrupt safe.
+	/// </summary>
 	void OnWakeInterrupt()
 	{
-		LastActivity = millis();
+		WakeEdge = true;
 	}
 
 	virtual bool Callback() final
 	{
-		UpdateState(HidReport);
+		if (WakeEdge)
+		{
+			// An edge raised in between is covered by this sample.
+			WakeEdge = false;
+			UsbWaiting = false;
+			OnWakeEdge();
+		}
+		else if (UsbWaiting)
+		{
+			if (!IsUsbSampleDue())
+			{
+				return true;
+			}
+		}
+		else if (!IsSampleDue())
+		{
+			return true;
+		}
+
+		if (Target == TargetEnum::Usb
+			&& UsbSync != nullptr
+			&& !WaitForUsbPoll())
+		{
+			return true;
+		}
+
+		Latency.OnUpdateStart();
+		UpdateState(SampleReport);
+		DebounceSample(SampleReport);
+		Latch.Step(SampleReport);
+
+		const bool edge = (LastHidReport.buttons != SampleReport.buttons)
+			|| (LastHidReport.hat != SampleReport.hat);
+		Latency.OnUpdateEnd(edge);
+
+		if (edge)
+		{
+			LastHidReport.buttons = SampleReport.buttons;
+			LastHidReport.hat = SampleReport.hat;
+		}
+
+		if (Activity.Step(SampleReport))
+		{
+			OnActivity();
+		}
+
+		const uint32_t timestamp = millis();
+		const uint32_t idlePeriod = PollRate.GetPeriod(1, GetElapsedMillisSinceLastActivity());
 
 		switch (Target)
 		{
 		case TargetEnum::Usb:
-			if (UsbGamepad.IsReady())
+			if (Latency.IsInFlight()
+				&& UsbGamepad.IsReady())
+			{
+				// Endpoint is free again, last report was collected by the host.
+				Latency.OnComplete();
+			}
+
+			if (EmitUsb())
 			{
-				UsbGamepad.NotifyGamepad(HidReport);
+				Latch.Clear();
+			}
+
+			if (UsbSync != nullptr
+				&& UsbSync->IsLocked(micros()))
+			{
+				if (idlePeriod > 1)
+				{
+					// Idle tier, skip the polls in between.
+					DelaySample(idlePeriod - 1);
+				}
+				else
+				{
+					WaitForUsbSof();
+				}
+			}
+			else
+			{
+				DelaySample(idlePeriod);
 			}
-			TS::Task::delay(1);
 			break;
 		case TargetEnum::Ble:
-			BleGamepad.report(&HidReport);
-			TS::Task::delay(BlePeriod);
+			if (RadioSync != nullptr
+				&& RadioSync->IsLocked(micros()))
+			{
+				// Sampling keeps running into the latch, the report goes out right after the notification,
+				// on the upcoming connection event. Wake edges don't wait for it.
+				if (EmitNow
+					|| RadioSync->GetCount() != RadioCount)
+				{
+					EmitNow = false;
+					RadioCount = RadioSync->GetCount();
+					LastEmit = timestamp;
+					if (EmitBle())
+					{
+						Latch.Clear();
+					}
+				}
+
+				const uint32_t samplePeriod = (idlePeriod > SamplePeriod) ? idlePeriod : SamplePeriod;
+				const uint32_t millisToNext = RadioSync->GetMillisToNext(micros());
+				DelaySample((millisToNext < samplePeriod) ? millisToNext : samplePeriod);
+			}
+			else
+			{
+				if (EmitNow
+					|| ((timestamp - LastEmit) >= BlePeriod))
+				{
+					EmitNow = false;
+					LastEmit = timestamp;
+					if (EmitBle())
+					{
+						Latch.Clear();
+					}
+				}
+				DelaySample(GetNextSampleDelay(timestamp, (idlePeriod > SamplePeriod) ? idlePeriod : SamplePeriod));
+			}
 			break;
 		case TargetEnum::None:
 		default:
-			TS::Task::delay(BlePeriod);
+			Latch.Clear();
+			DelaySample(BlePeriod);
 			break;
 		}
 
-		if ((LastHidReport.buttons != HidReport.buttons)
-			|| (LastHidReport.hat != HidReport.hat))
-		{
-			LastHidReport.buttons = HidReport.buttons;
-			LastHidReport.hat = HidReport.hat;
-
-			OnActivity();
-		}
-
 		return true;
 	}
 
@@ -110,10 +282,114 @@ public:
 		if (Target != target)
 		{
 			Target = target;
+			ForceReport = true;
+			BleTx.Clear();
+			SampleDelay = 0;
+			UsbWaiting = false;
 			TS::Task::enableDelayed(0);
 		}
 	}
 
+	/// <summary>
+	/// Align BLE reports with the connection events, nullptr for the fixed period.
+	/// Input is still sampled at the sub-period rate into the latch.
+	/// Falls back to the fixed period while the notifications are not locked.
+	/// </summary>
+	/// <param name="radioSync"></param>
+	void SetRadioSync(const BleRadioSync* radioSync)
+	{
+		RadioSync = radioSync;
+	}
+
+	/// <summary>
+	/// Align USB sampling with the endpoint polls, nullptr for the fixed 1 ms polling.
+	/// Falls back to the fixed polling while there is no start-of-frame.
+	/// </summary>
+	/// <param name="usbSync"></param>
+	void SetUsbSync(UsbSofSync* usbSync)
+	{
+		UsbSync = usbSync;
+		if (UsbSync != nullptr)
+		{
+			UsbSync->SetListener(this);
+		}
+	}
+
+	/// <summary>
+	/// Replace the idle sampling tiers, see HidPollRate.
+	/// </summary>
+	void SetPollRateTiers(const uint32_t* idleMillis, const uint32_t* periodMillis, const uint8_t tierCount)
+	{
+		PollRate.SetTiers(idleMillis, periodMillis, tierCount);
+	}
+
+	/// <summary>
+	/// Axis movement that counts as activity, see HidActivityTracker.
+	/// </summary>
+	void SetActivityDeadband(const uint8_t deadband)
+	{
+		Activity.SetDeadband(deadband);
+	}
+
+	void GetActivityStats(HidActivityStatsStruct& stats) const
+	{
+		Activity.GetStats(stats);
+	}
+
+	/// <summary>
+	/// Get the report emission counters.
+	/// </summary>
+	/// <param name="reportStats"></param>
+	void GetReportStats(HidReportStatsStruct& reportStats) const
+	{
+		reportStats = ReportStats;
+	}
+
+	void ClearReportStats()
+	{
+		ReportStats = {};
+	}
+
+	/// <summary>
+	/// Get the input-to-air latency summaries.
+	/// Empty unless RETRO_BLE_LATENCY_PROBE is defined.
+	/// </summary>
+	/// <param name="summary"></param>
+	void GetLatency(HidLatency::SummaryStruct& summary) const
+	{
+		Latency.GetSummary(summary);
+	}
+
+	void LogLatency(Print& serial) const
+	{
+		Latency.Log(serial);
+	}
+
+	/// <summary>
+	/// IBleTxListener interface.
+	/// </summary>
+	virtual void OnBleTxComplete(const uint8_t count) final
+	{
+		if (BleTx.OnComplete(count) > 0)
+		{
+			Latency.OnComplete();
+		}
+	}
+
+	virtual void OnBleTxOther() final
+	{
+		BleTx.OnQueued(false);
+	}
+
+	/// <summary>
+	/// IUsbSofListener interface.
+	/// From the USB task, only hands the sampling point over to Callback().
+	/// </summary>
+	virtual void OnUsbSampleDue() final
+	{
+		UsbSampleDue.store(true, std::memory_order_release);
+	}
+
 	virtual uint32_t GetElapsedMillisSinceLastActivity() const final
 	{
 		return millis() - LastActivity;
@@ -123,7 +399,270 @@ protected:
 	void OnActivity()
 	{
 		LastActivity = millis();
+		PollRate.Reset();
+	}
+
+private:
+	void OnWakeEdge()
+	{
+		OnActivity();
+		EmitNow = true;
+		Latency.OnWakeInterrupt();
+	}
+
+	/// <summary>
+	/// Sleep until the next sample, in wake poll steps.
+	/// </summary>
+	void DelaySample(const uint32_t delay)
+	{
+		SampleDelayStart = millis();
+		SampleDelay = delay;
+		TS::Task::delay((delay < RetroBle::BleConfig::IdleSampling::WakePollMillis) ? delay : RetroBle::BleConfig::IdleSampling::WakePollMillis);
+	}
+
+	/// <summary>
+	/// Wake poll, sleeps again for the rest of the sample delay.
+	/// </summary>
+	/// <returns>True when the sample delay is over.</returns>
+	const bool IsSampleDue()
+	{
+		const uint32_t elapsed = millis() - SampleDelayStart;
+		if (elapsed >= SampleDelay)
+		{
+			return true;
+		}
+
+		const uint32_t remaining = SampleDelay - elapsed;
+		TS::Task::delay((remaining < RetroBle::BleConfig::IdleSampling::WakePollMillis) ? remaining : RetroBle::BleConfig::IdleSampling::WakePollMillis);
+
+		return false;
+	}
+
+	/// <summary>
+	/// Samples once per poll, on the start-of-frame ahead of it.
+	/// </summary>
+	/// <returns>True when it is time to sample, false if the task is waiting for the start-of-frame.</returns>
+	const bool WaitForUsbPoll()
+	{
+		if (!UsbSync->IsLocked(micros()))
+		{
+			return true;
+		}
+
+		if (UsbSync->TakeSample(UsbGamepad.IsReady()))
+		{
+			return true;
+		}
+
+		WaitForUsbSof();
+
+		return false;
+	}
+
+	/// <summary>
+	/// Wait for the start-of-frame ahead of the next poll, checked on every scheduler pass.
+	/// The USB link is bus powered, so there's no sleep to lose.
+	/// </summary>
+	void WaitForUsbSof()
+	{
+		UsbWaiting = true;
+		SampleDelay = 0;
+		TS::Task::delay(0);
+	}
+
+	/// <summary>
+	/// Times out with the start-of-frame lock, to fall back to the fixed polling.
+	/// </summary>
+	/// <returns>True when the start-of-frame was signaled, or the lock was lost.</returns>
+	const bool IsUsbSampleDue()
+	{
+		if (UsbSampleDue.exchange(false, std::memory_order_acquire)
+			|| !UsbSync->IsLocked(micros()))
+		{
+			UsbWaiting = false;
+			return true;
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Merge the latest sample with the latched taps and send it to USB, if pending.
+	/// </summary>
+	/// <returns>True if the latched state was delivered or was already up to date.</returns>
+	const bool EmitUsb()
+	{
+		HidReport = SampleReport;
+		Latch.Merge(HidReport);
+
+		if (IsReportPending())
+		{
+			if (UsbGamepad.IsReady()
+				&& UsbGamepad.NotifyGamepad(HidReport))
+			{
+				if (UsbSync != nullptr)
+				{
+					UsbSync->OnReportQueued();
+				}
+				OnReportSent();
+				return true;
+			}
+
+			return false;
+		}
+
+		ReportStats.Suppressed++;
+		return true;
+	}
+
+	/// <summary>
+	/// Merge the latest sample with the latched taps and send it to BLE, if pending.
+	/// </summary>
+	/// <returns>True if the latched state was delivered or was already up to date.</returns>
+	const bool EmitBle()
+	{
+		HidReport = SampleReport;
+		Latch.Merge(HidReport);
+
+		if (IsReportPending())
+		{
+			if (BleGamepad.report(&HidReport))
+			{
+				BleTx.OnQueued(true);
+				OnReportSent();
+				return true;
+			}
+
+			return false;
+		}
+
+		ReportStats.Suppressed++;
+		return true;
+	}
+
+	/// <summary>
+	/// Sub-period sampling, without overshooting the next report.
+	/// </summary>
+	const uint32_t GetNextSampleDelay(const uint32_t timestamp, const uint32_t samplePeriod) const
+	{
+		const uint32_t elapsed = timestamp - LastEmit;
+
+		if (elapsed >= BlePeriod)
+		{
+			return 0;
+		}
+		else if ((BlePeriod - elapsed) < samplePeriod)
+		{
+			return BlePeriod - elapsed;
+		}
+		else
+		{
+			return samplePeriod;
+		}
+	}
+
+	/// <summary>
+	/// Emission policy: send on change, on forced (target switch) and on heartbeat.
+	/// </summary>
+	/// <returns>True if the current report should be sent.</returns>
+	const bool IsReportPending() const
+	{
+		return ForceReport
+			|| (memcmp(&LastSentReport, &HidReport, sizeof(hid_gamepad_report_t)) != 0)
+			|| (HeartbeatPeriod > 0 && ((millis() - LastSent) >= HeartbeatPeriod));
+	}
+
+	void OnReportSent()
+	{
+		LastSentReport = HidReport;
+		LastSent = millis();
+		ForceReport = false;
+		ReportStats.Sent++;
+		Latency.OnSend();
 	}
 };
+
+/// <summary>
+/// Gamepad HID task with buttons and hat debounced, bit-parallel, with the device's compile-time profile.
+/// </summary>
+/// <typeparam name="Debounce">DebounceProfile for buttons and hat.</typeparam>
+template<typename Debounce = DebounceNone>
+class DebouncedHidGamepadTask : public HidGamepadTask
+{
+private:
+	typename Debounce::template Engine<uint32_t> ButtonsDebounce{};
+	typename Debounce::template Engine<uint8_t> HatDebounce{};
+
+public:
+	DebouncedHidGamepadTask(TS::Scheduler& scheduler,
+		UsbHidGamepad& usbGamepad,
+		BLEHidGamepad& bleGamepad,
+		const uint32_t bleUpdatePeriod,
+		const uint32_t heartbeatPeriod = RetroBle::BleConfig::REPORT_HEARTBEAT_PERIOD_MILLIS,
+		const uint32_t samplePeriod = RetroBle::BleConfig::INPUT_SAMPLE_PERIOD_MILLIS)
+		: HidGamepadTask(scheduler, usbGamepad, bleGamepad, bleUpdatePeriod, heartbeatPeriod, samplePeriod)
+	{}
+
+protected:
+	virtual void DebounceSample(hid_gamepad_report_t& sample) final
+	{
+		sample.buttons = ButtonsDebounce.Step(sample.buttons);
+		sample.hat = GetHat(HatDebounce.Step(GetHatDirections(sample.hat)));
+	}
+
+private:
+	/// <summary>
+	/// Hat to direction bits, as PortCapture::DPadBit.
+	/// </summary>
+	static const uint8_t GetHatDirections(const uint8_t hat)
+	{
+		static constexpr uint8_t Up = 1 << 0;
+		static constexpr uint8_t Down = 1 << 1;
+		static constexpr uint8_t Left = 1 << 2;
+		static constexpr uint8_t Right = 1 << 3;
+		static constexpr uint8_t Lut[GAMEPAD_HAT_UP_LEFT + 1] =
+		{
+			0,				// GAMEPAD_HAT_CENTERED
+			Up,				// GAMEPAD_HAT_UP
+			Up | Right,		// GAMEPAD_HAT_UP_RIGHT
+			Right,			// GAMEPAD_HAT_RIGHT
+			Down | Right,	// GAMEPAD_HAT_DOWN_RIGHT
+			Down,			// GAMEPAD_HAT_DOWN
+			Down | Left,	// GAMEPAD_HAT_DOWN_LEFT
+			Left,			// GAMEPAD_HAT_LEFT
+			Up | Left		// GAMEPAD_HAT_UP_LEFT
+		};
+
+		return (hat <= GAMEPAD_HAT_UP_LEFT) ? Lut[hat] : 0;
+	}
+
+	/// <summary>
+	/// Direction bits to hat, opposite directions cancel out.
+	/// </summary>
+	static const uint8_t GetHat(const uint8_t directions)
+	{
+		static constexpr uint8_t Lut[16] =
+		{
+			GAMEPAD_HAT_CENTERED,
+			GAMEPAD_HAT_UP,
+			GAMEPAD_HAT_DOWN,
+			GAMEPAD_HAT_CENTERED,
+			GAMEPAD_HAT_LEFT,
+			GAMEPAD_HAT_UP_LEFT,
+			GAMEPAD_HAT_DOWN_LEFT,
+			GAMEPAD_HAT_LEFT,
+			GAMEPAD_HAT_RIGHT,
+			GAMEPAD_HAT_UP_RIGHT,
+			GAMEPAD_HAT_DOWN_RIGHT,
+			GAMEPAD_HAT_RIGHT,
+			GAMEPAD_HAT_CENTERED,
+			GAMEPAD_HAT_UP,
+			GAMEPAD_HAT_DOWN,
+			GAMEPAD_HAT_CENTERED
+		};
+
+		return Lut[directions & 0x0F];
+	}
+};
+#endif
 #endif
-#endif
\ No newline at end of file
@@ -8,41 +8,84 @@
 #include <InternalFileSystem.h>
 #include <bluefruit.h>
 
+#include "../Ble/BleConfig.h"
+#include "../Ble/IBleListener.h"
+#include "../Ble/BleTxOrder.h"
 #include "../Usb/UsbHidKeyboard.h"
 #include "../BatteryManager/ISleep.h"
+#include "../Input/VerticalDebounce.h"
 #include "IHidDevice.h"
+#include "KeyEventQueue.h"
+#include "HidLatencyProbe.h"
+#include "HidPollRate.h"
 
 /// <summary>
 /// Abstract task for Keyboard HID reporting, with fixed period.
 /// Combined HID reporting, for BLE or USB Keyboard.
+/// Key state is sampled at a sub-period rate and every transition is queued as a key event.
+/// Sampling slows down through the idle tiers while no key changes, and snaps back on the next edge or wake interrupt.
+/// The wake interrupt only raises a flag, polled by the task between idle samples.
+/// Queued events are drained in order into a sequence of reports:
+///		USB - Back-to-back, as fast as the endpoint accepts them.
+///		BLE - One report per BlePeriod, which should match the connection interval.
 /// Inherited classes must implement virtual methods.
 ///////		OnStart - Setup pin and prepare for runtime operation.
 ///////		OnStop - Stop any active operation and setup pins for wake on interrupt.
 ///		UpdateState - Update keyboard state and populate HID report.
 ///		IsPowerDownRequested - Keyboard has requested device to power down.
+/// Alternatively, scanners can skip UpdateState and push their transitions with PushKeyEvent.
+/// Sampled keys go through DebounceKeys as a 256 key bitmap, pass-through here, see DebouncedHidKeyboardTask.
 /// </summary>
-class HidKeyboardTask : public virtual IHidDevice, private TS::Task
+class HidKeyboardTask : public virtual IHidDevice, public virtual IBleTxListener, private TS::Task
 {
+protected:
+	static constexpr uint8_t KeyWords = 256 / 32;
+
+private:
+	static constexpr uint8_t KeyCount = sizeof(hid_keyboard_report_t::keycode);
+	static constexpr uint8_t ModifierFirst = 0xE0;
+	static constexpr uint8_t ModifierCount = 8;
+	static constexpr uint8_t EventQueueSize = 32;
+	static constexpr uint8_t KeyFirst = 4; // Skip the reserved and error usages.
+
 private:
 	UsbHidKeyboard& UsbKeyboard;
 	BLEHidAdafruit& BleKeyboard;
 
 private:
-	const uint32_t UsbPeriod;
 	const uint32_t BlePeriod;
+	const uint32_t SamplePeriod;
 
 private:
+	KeyEventQueue<EventQueueSize> EventQueue{};
+	HidLatency::Probe Latency{};
+	BleTxOrder BleTx{};
+
+	// Last debounced state, as a key bitmap.
+	uint32_t KeyState[KeyWords]{};
+	hid_keyboard_report_t SampleReport{};
+
+	// State as seen by the host.
 	hid_keyboard_report_t HidReport{};
-	hid_keyboard_report_t LastHidReport{};
 
 private:
 	//void (*WakeInterrupt)() = nullptr; //TODO:
+	HidPollRate PollRate{};
 	uint32_t LastActivity = 0;
+	uint32_t LastEmit = 0;
+	uint32_t SampleDelayStart = 0;
+	uint32_t SampleDelay = 0;
+	volatile bool WakeEdge = false;
 	TargetEnum Target = TargetEnum::None;
 
 protected:
 	virtual void UpdateState(hid_keyboard_report_t& hidReport) {}
 
+	/// <summary>
+	/// Filter the sampled key bitmap in place, before the transitions are queued.
+	/// </summary>
+	virtual void DebounceKeys(uint32_t keys[KeyWords]) {}
+
 	/// <summary>
 	/// ISleep interface.
 	/// </summary>
@@ -57,91 +100,480 @@ public:
 	virtual bool IsPowerDownRequested() const { return false; }
 
 public:
+	/// <summary>
+	/// </summary>
+	/// <param name="usbUpdatePeriod">Deprecated, ignored. USB reports are drained back-to-back, input is sampled every samplePeriod.</param>
 	HidKeyboardTask(TS::Scheduler& scheduler,
 		UsbHidKeyboard& usbKeyboard,
 		BLEHidAdafruit& bleKeyboard,
 		const uint32_t usbUpdatePeriod = 5,
-		const uint32_t bleUpdatePeriod = 15)
+		const uint32_t bleUpdatePeriod = 15,
+		const uint32_t samplePeriod = RetroBle::BleConfig::INPUT_SAMPLE_PERIOD_MILLIS)
 		: IHidDevice()
 		, TS::Task(TASK_IMMEDIATE, TASK_FOREVER, &scheduler, false)
 		, UsbKeyboard(usbKeyboard)
 		, BleKeyboard(bleKeyboard)
-		, UsbPeriod(usbUpdatePeriod)
 		, BlePeriod(bleUpdatePeriod)
+		, SamplePeriod(samplePeriod > 0 ? samplePeriod : 1)
 	{
 	}
 
+	/// <summary>
+	/// Key edge interrupt: sampled on the next wake poll, without waiting out the idle tier.
+	/// Only raises the flag, the scheduler isn't interrupt safe.
+	/// </summary>
 	void OnWakeInterrupt()
 	{
-		LastActivity = millis();
+		WakeEdge = true;
 	}
 
 	virtual bool Callback() final
 	{
-		UpdateState(HidReport);
+		if (WakeEdge)
+		{
+			// An edge raised in between is covered by this sample.
+			WakeEdge = false;
+			OnActivity();
+			Latency.OnWakeInterrupt();
+		}
+		else if (!IsSampleDue())
+		{
+			return true;
+		}
+
+		Latency.OnUpdateStart();
+		UpdateState(SampleReport);
+		QueueTransitions();
+		Latency.OnUpdateEnd(false);
+
+		const uint32_t timestamp = millis();
+		const uint32_t samplePeriod = PollRate.GetPeriod(SamplePeriod, GetElapsedMillisSinceLastActivity());
 
 		switch (Target)
 		{
 		case TargetEnum::Usb:
-			if (UsbKeyboard.IsReady())
+			if (Latency.IsInFlight()
+				&& UsbKeyboard.IsReady())
+			{
+				// Endpoint is free again, last report was collected by the host.
+				Latency.OnComplete();
+			}
+
+			if (!EventQueue.IsEmpty()
+				&& UsbKeyboard.IsReady())
+			{
+				LastEmit = timestamp;
+				EmitUsb();
+			}
+
+			if (EventQueue.IsEmpty())
 			{
-				UsbKeyboard.NotifyKeyboard(HidReport);
+				DelaySample(samplePeriod);
+			}
+			else
+			{
+				// Back-to-back until the queue is drained.
+				DelaySample(1);
 			}
-			TS::Task::delay(UsbPeriod);
 			break;
 		case TargetEnum::Ble:
-			BleKeyboard.keyboardReport(&HidReport);
-			TS::Task::delay(BlePeriod);
+			if ((timestamp - LastEmit) >= BlePeriod)
+			{
+				LastEmit = timestamp;
+				EmitBle();
+			}
+			DelaySample(GetNextSampleDelay(timestamp, BlePeriod, samplePeriod));
 			break;
 		case TargetEnum::None:
 		default:
-			TS::Task::delay(BlePeriod);
+			EventQueue.Clear();
+			DelaySample(BlePeriod);
 			break;
 		}
 
-		if ((LastHidReport.modifier != HidReport.modifier))
+		return true;
+	}
+
+	void SetTarget(TargetEnum target) final
+	{
+		if (Target != target)
 		{
-			LastHidReport.modifier = HidReport.modifier;
-			memcpy(LastHidReport.keycode, HidReport.keycode, sizeof(hid_keyboard_report_t::keycode));
+			Target = target;
 
-			OnActivity();
+			// New host starts from a clear state, held keys are re-queued as presses.
+			EventQueue.Clear();
+			BleTx.Clear();
+			for (uint8_t i = 0; i < KeyWords; i++)
+			{
+				KeyState[i] = 0;
+			}
+			HidReport = {};
+			SampleDelay = 0;
+			TS::Task::enableDelayed(0);
+		}
+	}
+
+	uint32_t GetElapsedMillisSinceLastActivity() const final
+	{
+		return millis() - LastActivity;
+	}
+
+	/// <summary>
+	/// Replace the idle sampling tiers, see HidPollRate.
+	/// </summary>
+	void SetPollRateTiers(const uint32_t* idleMillis, const uint32_t* periodMillis, const uint8_t tierCount)
+	{
+		PollRate.SetTiers(idleMillis, periodMillis, tierCount);
+	}
+
+	/// <summary>
+	/// Get the key event queue counters.
+	/// </summary>
+	/// <param name="stats"></param>
+	void GetKeyEventStats(KeyEventStatsStruct& stats) const
+	{
+		EventQueue.GetStats(stats);
+	}
+
+	/// <summary>
+	/// Get the key-to-air latency summaries.
+	/// Empty unless RETRO_BLE_LATENCY_PROBE is defined.
+	/// </summary>
+	/// <param name="summary"></param>
+	void GetLatency(HidLatency::SummaryStruct& summary) const
+	{
+		Latency.GetSummary(summary);
+	}
+
+	void LogLatency(Print& serial) const
+	{
+		Latency.Log(serial);
+	}
+
+	/// <summary>
+	/// IBleTxListener interface.
+	/// </summary>
+	virtual void OnBleTxComplete(const uint8_t count) final
+	{
+		if (BleTx.OnComplete(count) > 0)
+		{
+			Latency.OnComplete();
+		}
+	}
+
+	virtual void OnBleTxOther() final
+	{
+		BleTx.OnQueued(false);
+	}
+
+protected:
+	void OnActivity()
+	{
+		LastActivity = millis();
+		PollRate.Reset();
+	}
+
+	/// <summary>
+	/// Queue a single key transition, for scanners that track their own edges.
+	/// </summary>
+	/// <param name="keyCode">HID key usage, modifiers as [0xE0 ; 0xE7].</param>
+	/// <param name="down">True on press, false on release.</param>
+	/// <returns>False if the event queue overflowed.</returns>
+	const bool PushKeyEvent(const uint8_t keyCode, const bool down)
+	{
+		OnActivity();
+
+		return EventQueue.Push(keyCode, down, micros());
+	}
+
+private:
+	/// <summary>
+	/// Sleep until the next sample, in wake poll steps.
+	/// </summary>
+	void DelaySample(const uint32_t delay)
+	{
+		SampleDelayStart = millis();
+		SampleDelay = delay;
+		TS::Task::delay((delay < RetroBle::BleConfig::IdleSampling::WakePollMillis) ? delay : RetroBle::BleConfig::IdleSampling::WakePollMillis);
+	}
+
+	/// <summary>
+	/// Wake poll, sleeps again for the rest of the sample delay.
+	/// </summary>
+	/// <returns>True when the sample delay is over.</returns>
+	const bool IsSampleDue()
+	{
+		const uint32_t elapsed = millis() - SampleDelayStart;
+		if (elapsed >= SampleDelay)
+		{
 			return true;
 		}
 
-		for (size_t i = 0; i < sizeof(hid_keyboard_report_t::keycode); i++)
+		const uint32_t remaining = SampleDelay - elapsed;
+		TS::Task::delay((remaining < RetroBle::BleConfig::IdleSampling::WakePollMillis) ? remaining : RetroBle::BleConfig::IdleSampling::WakePollMillis);
+
+		return false;
+	}
+
+	/// <summary>
+	/// Debounce the latest sample and queue every transition against the previous state.
+	/// Releases are queued before presses.
+	/// Only queued transitions are committed to the state, the ones dropped on overflow are queued again on the next sample.
+	/// </summary>
+	void QueueTransitions()
+	{
+		uint32_t keys[KeyWords]{};
+		GetKeyBitmap(SampleReport, keys);
+		DebounceKeys(keys);
+
+		uint32_t changes[KeyWords];
+		bool changed = false;
+		for (uint8_t i = 0; i < KeyWords; i++)
+		{
+			changes[i] = keys[i] ^ KeyState[i];
+			changed |= changes[i] != 0;
+		}
+
+		if (!changed)
 		{
-			if ((LastHidReport.keycode[i] != HidReport.keycode[i]))
+			return;
+		}
+
+		for (uint8_t i = 0; i < KeyWords; i++)
+		{
+			KeyState[i] &= ~QueueWord(i, changes[i] & KeyState[i], false);
+		}
+
+		for (uint8_t i = 0; i < KeyWords; i++)
+		{
+			KeyState[i] |= QueueWord(i, changes[i] & keys[i], true);
+		}
+	}
+
+	/// <summary>
+	/// Queue the transitions of one bitmap word, in key order.
+	/// </summary>
+	/// <returns>Bits of the transitions that were queued.</returns>
+	const uint32_t QueueWord(const uint8_t word, uint32_t changes, const bool down)
+	{
+		uint32_t queued = 0;
+		while (changes != 0)
+		{
+			const uint8_t bit = __builtin_ctz(changes);
+			changes &= changes - 1;
+
+			if (PushKeyEvent((word * 32) + bit, down))
 			{
-				LastHidReport.modifier = HidReport.modifier;
-				memcpy(LastHidReport.keycode, HidReport.keycode, sizeof(hid_keyboard_report_t::keycode));
+				queued |= (uint32_t)1 << bit;
+			}
+		}
 
-				OnActivity();
-				return true;
+		return queued;
+	}
+
+	/// <summary>
+	/// Report to key bitmap, modifiers map to their usage codes [0xE0 ; 0xE7].
+	/// </summary>
+	static void GetKeyBitmap(const hid_keyboard_report_t& report, uint32_t keys[KeyWords])
+	{
+		keys[ModifierFirst / 32] |= (uint32_t)report.modifier << (ModifierFirst % 32);
+
+		for (uint8_t i = 0; i < KeyCount; i++)
+		{
+			const uint8_t keyCode = report.keycode[i];
+			if (keyCode >= KeyFirst)
+			{
+				keys[keyCode / 32] |= (uint32_t)1 << (keyCode % 32);
+			}
+		}
+	}
+
+	void EmitUsb()
+	{
+		hid_keyboard_report_t report = HidReport;
+		uint8_t rollovers = 0;
+		const uint8_t applied = BuildReport(report, rollovers);
+
+		if (applied > 0)
+		{
+			Latency.OnEdge(EventQueue.Peek(0).Timestamp);
+			if (UsbKeyboard.NotifyKeyboard(report))
+			{
+				HidReport = report;
+				EventQueue.Pop(applied);
+				EventQueue.OnRollover(rollovers);
+				Latency.OnSend();
+			}
+		}
+	}
+
+	void EmitBle()
+	{
+		hid_keyboard_report_t report = HidReport;
+		uint8_t rollovers = 0;
+		const uint8_t applied = BuildReport(report, rollovers);
+
+		if (applied > 0)
+		{
+			Latency.OnEdge(EventQueue.Peek(0).Timestamp);
+			if (BleKeyboard.keyboardReport(&report))
+			{
+				BleTx.OnQueued(true);
+				HidReport = report;
+				EventQueue.Pop(applied);
+				EventQueue.OnRollover(rollovers);
+				Latency.OnSend();
+			}
+		}
+	}
+
+	/// <summary>
+	/// Apply the oldest queued events to the report.
+	/// Stops before an event touches a key already changed in this report, so no transition is lost.
+	/// </summary>
+	/// <param name="rollovers">Presses dropped for lack of a key slot, only count once the report is sent.</param>
+	/// <returns>Number of events applied to the report.</returns>
+	const uint8_t BuildReport(hid_keyboard_report_t& report, uint8_t& rollovers)
+	{
+		uint8_t touched[EventQueueSize];
+		uint8_t applied = 0;
+
+		while (applied < EventQueue.GetCount())
+		{
+			const KeyEventStruct& event = EventQueue.Peek(applied);
+
+			for (uint8_t i = 0; i < applied; i++)
+			{
+				if (touched[i] == event.KeyCode)
+				{
+					return applied;
+				}
+			}
+
+			if (!ApplyEvent(report, event))
+			{
+				rollovers++;
+			}
+			touched[applied++] = event.KeyCode;
+		}
+
+		return applied;
+	}
+
+	/// <returns>False if a press had no free key slot.</returns>
+	static const bool ApplyEvent(hid_keyboard_report_t& report, const KeyEventStruct& event)
+	{
+		if (event.KeyCode >= ModifierFirst
+			&& event.KeyCode < (ModifierFirst + ModifierCount))
+		{
+			const uint8_t mask = 1 << (event.KeyCode - ModifierFirst);
+			if (event.Down)
+			{
+				report.modifier |= mask;
+			}
+			else
+			{
+				report.modifier &= ~mask;
+			}
+		}
+		else if (event.Down)
+		{
+			if (!HasKey(report, event.KeyCode))
+			{
+				for (uint8_t i = 0; i < KeyCount; i++)
+				{
+					if (report.keycode[i] == 0)
+					{
+						report.keycode[i] = event.KeyCode;
+						return true;
+					}
+				}
+
+				// No free slot.
+				return false;
+			}
+		}
+		else
+		{
+			// Remove and keep the remaining keys packed.
+			uint8_t write = 0;
+			for (uint8_t i = 0; i < KeyCount; i++)
+			{
+				if (report.keycode[i] != event.KeyCode)
+				{
+					report.keycode[write++] = report.keycode[i];
+				}
+			}
+			while (write < KeyCount)
+			{
+				report.keycode[write++] = 0;
 			}
 		}
 
 		return true;
 	}
 
-	void SetTarget(TargetEnum target) final
+	const uint32_t GetNextSampleDelay(const uint32_t timestamp, const uint32_t reportPeriod, const uint32_t samplePeriod) const
 	{
-		if (Target != target)
+		const uint32_t elapsed = timestamp - LastEmit;
+
+		if (elapsed >= reportPeriod)
 		{
-			Target = target;
-			TS::Task::enableDelayed(0);
+			return 0;
+		}
+		else if ((reportPeriod - elapsed) < samplePeriod)
+		{
+			return reportPeriod - elapsed;
+		}
+		else
+		{
+			return samplePeriod;
 		}
 	}
 
-	uint32_t GetElapsedMillisSinceLastActivity() const final
+	static const bool HasKey(const hid_keyboard_report_t& report, const uint8_t keyCode)
+	{
+		for (uint8_t i = 0; i < KeyCount; i++)
+		{
+			if (report.keycode[i] == keyCode)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+};
+
+/// <summary>
+/// Keyboard HID task with keys debounced, bit-parallel, with the device's compile-time profile.
+/// </summary>
+/// <typeparam name="Debounce">DebounceProfile for all keys.</typeparam>
+template<typename Debounce = DebounceNone>
+class DebouncedHidKeyboardTask : public HidKeyboardTask
+{
+private:
+	typename Debounce::template Engine<uint32_t> KeyDebounce[KeyWords]{};
+
+public:
+	DebouncedHidKeyboardTask(TS::Scheduler& scheduler,
+		UsbHidKeyboard& usbKeyboard,
+		BLEHidAdafruit& bleKeyboard,
+		const uint32_t usbUpdatePeriod = 5,
+		const uint32_t bleUpdatePeriod = 15,
+		const uint32_t samplePeriod = RetroBle::BleConfig::INPUT_SAMPLE_PERIOD_MILLIS)
+		: HidKeyboardTask(scheduler, usbKeyboard, bleKeyboard, usbUpdatePeriod, bleUpdatePeriod, samplePeriod)
 	{
-		return millis() - LastActivity;
 	}
 
 protected:
-	void OnActivity()
+	virtual void DebounceKeys(uint32_t keys[KeyWords]) final
 	{
-		LastActivity = millis();
+		for (uint8_t i = 0; i < KeyWords; i++)
+		{
+			keys[i] = KeyDebounce[i].Step(keys[i]);
+		}
 	}
 };
 #endif
-#endif
\ No newline at end of file
+#endif
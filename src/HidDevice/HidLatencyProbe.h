@@ -0,0 +1,196 @@
+// HidLatencyProbe.h
+
+#ifndef _HID_LATENCY_PROBE_h
+#define _HID_LATENCY_PROBE_h
+
+#include <Arduino.h>
+
+#include "../Framework/LatencyHistogram.h"
+
+/// <summary>
+/// Input-to-air latency instrumentation for the HID report pipeline.
+/// Timestamps (micros) the wake interrupt, UpdateState start/end, the report call and its completion.
+/// Define RETRO_BLE_LATENCY_PROBE to enable, otherwise every call compiles to nothing.
+/// </summary>
+namespace HidLatency
+{
+	/// <summary>
+	/// Latency summaries, one per pipeline stage.
+	/// </summary>
+	struct __attribute__((packed)) SummaryStruct
+	{
+		/// <summary>
+		/// UpdateState duration.
+		/// </summary>
+		LatencySummaryStruct Update{};
+
+		/// <summary>
+		/// From input edge to the report call.
+		/// </summary>
+		LatencySummaryStruct Send{};
+
+		/// <summary>
+		/// From input edge to the report transfer completion.
+		/// </summary>
+		LatencySummaryStruct Complete{};
+	};
+
+#if defined(RETRO_BLE_LATENCY_PROBE)
+	class Probe
+	{
+	private:
+		LatencyHistogram Update{};
+		LatencyHistogram Send{};
+		LatencyHistogram Complete{};
+
+	private:
+		volatile uint32_t WakeTimestamp = 0;
+		volatile bool WakePending = false;
+
+		uint32_t UpdateStart = 0;
+		uint32_t EdgeTimestamp = 0;
+		bool EdgePending = false;
+
+		uint32_t InFlightEdge = 0;
+		bool InFlight = false;
+
+	public:
+		/// <summary>
+		/// Input wake interrupt, best edge timestamp available.
+		/// </summary>
+		void OnWakeInterrupt()
+		{
+			WakeTimestamp = micros();
+			WakePending = true;
+		}
+
+		void OnUpdateStart()
+		{
+			UpdateStart = micros();
+		}
+
+		/// <summary>
+		/// </summary>
+		/// <param name="changed">True if the sample has a new input edge.</param>
+		void OnUpdateEnd(const bool changed)
+		{
+			Update.Add(micros() - UpdateStart);
+
+			if (changed && !EdgePending)
+			{
+				EdgePending = true;
+				if (WakePending)
+				{
+					EdgeTimestamp = WakeTimestamp;
+				}
+				else
+				{
+					EdgeTimestamp = UpdateStart;
+				}
+			}
+			WakePending = false;
+		}
+
+		/// <summary>
+		/// Input edge with a known capture timestamp, e.g. a queued key event.
+		/// </summary>
+		void OnEdge(const uint32_t timestamp)
+		{
+			if (!EdgePending)
+			{
+				EdgePending = true;
+				EdgeTimestamp = timestamp;
+			}
+		}
+
+		/// <summary>
+		/// Report was handed over to the USB/BLE stack.
+		/// </summary>
+		void OnSend()
+		{
+			if (EdgePending)
+			{
+				EdgePending = false;
+				Send.Add(micros() - EdgeTimestamp);
+				InFlightEdge = EdgeTimestamp;
+				InFlight = true;
+			}
+		}
+
+		/// <summary>
+		/// Report transfer completed.
+		/// </summary>
+		void OnComplete()
+		{
+			if (InFlight)
+			{
+				InFlight = false;
+				Complete.Add(micros() - InFlightEdge);
+			}
+		}
+
+		const bool IsInFlight() const
+		{
+			return InFlight;
+		}
+
+		void Clear()
+		{
+			Update.Clear();
+			Send.Clear();
+			Complete.Clear();
+		}
+
+		void GetSummary(SummaryStruct& summary) const
+		{
+			Update.GetSummary(summary.Update);
+			Send.GetSummary(summary.Send);
+			Complete.GetSummary(summary.Complete);
+		}
+
+		void Log(Print& serial) const
+		{
+			SummaryStruct summary{};
+			GetSummary(summary);
+
+			serial.println(F("Latency (us)\tcount\tmin\tavg\tp99\tmax"));
+			LogLine(serial, F("Update\t"), summary.Update);
+			LogLine(serial, F("Send\t"), summary.Send);
+			LogLine(serial, F("Complete"), summary.Complete);
+		}
+
+	private:
+		template<typename LabelType>
+		static void LogLine(Print& serial, const LabelType label, const LatencySummaryStruct& summary)
+		{
+			serial.print(label);
+			serial.print('\t');
+			serial.print(summary.Count);
+			serial.print('\t');
+			serial.print(summary.Min);
+			serial.print('\t');
+			serial.print(summary.Average);
+			serial.print('\t');
+			serial.print(summary.P99);
+			serial.print('\t');
+			serial.println(summary.Max);
+		}
+	};
+#else
+	class Probe
+	{
+	public:
+		void OnWakeInterrupt() {}
+		void OnUpdateStart() {}
+		void OnUpdateEnd(const bool changed) {}
+		void OnEdge(const uint32_t timestamp) {}
+		void OnSend() {}
+		void OnComplete() {}
+		const bool IsInFlight() const { return false; }
+		void Clear() {}
+		void GetSummary(SummaryStruct& summary) const {}
+		void Log(Print& serial) const {}
+	};
+#endif
+}
+#endif
@@ -0,0 +1,83 @@
+// HidPollRate.h
+
+#ifndef _HID_POLL_RATE_h
+#define _HID_POLL_RATE_h
+
+#include <stdint.h>
+
+#include "../Ble/BleConfig.h"
+
+/// <summary>
+/// Activity driven input sampling period.
+/// Full rate while inputs change, steps down through the idle tiers as the idle time grows.
+/// Tiers only advance, Reset on activity snaps back to full rate.
+/// </summary>
+class HidPollRate
+{
+private:
+	const uint32_t* IdleMillis;
+	const uint32_t* PeriodMillis;
+	uint8_t TierCount;
+
+private:
+	uint8_t Tier = 0;
+
+public:
+	HidPollRate(const uint32_t* idleMillis = RetroBle::BleConfig::IdleSampling::IdleMillis,
+		const uint32_t* periodMillis = RetroBle::BleConfig::IdleSampling::PeriodMillis,
+		const uint8_t tierCount = RetroBle::BleConfig::IdleSampling::TierCount)
+		: IdleMillis(idleMillis)
+		, PeriodMillis(periodMillis)
+		, TierCount(tierCount)
+	{}
+
+	/// <summary>
+	/// Replace the idle tiers, 0 tiers for a fixed rate.
+	/// </summary>
+	/// <param name="idleMillis">Idle time to enter each tier, ascending.</param>
+	/// <param name="periodMillis">Sampling period of each tier.</param>
+	/// <param name="tierCount"></param>
+	void SetTiers(const uint32_t* idleMillis, const uint32_t* periodMillis, const uint8_t tierCount)
+	{
+		IdleMillis = idleMillis;
+		PeriodMillis = periodMillis;
+		TierCount = tierCount;
+		Tier = 0;
+	}
+
+	void Reset()
+	{
+		Tier = 0;
+	}
+
+	/// <summary>
+	/// 0 for full rate.
+	/// </summary>
+	const uint8_t GetTier() const
+	{
+		return Tier;
+	}
+
+	/// <summary>
+	/// Sampling period for the current idle time.
+	/// </summary>
+	/// <param name="fullPeriod">Sampling period at full rate.</param>
+	/// <param name="idleMillis">Elapsed time since the last activity.</param>
+	const uint32_t GetPeriod(const uint32_t fullPeriod, const uint32_t idleMillis)
+	{
+		while (Tier < TierCount
+			&& idleMillis >= IdleMillis[Tier])
+		{
+			Tier++;
+		}
+
+		if (Tier == 0
+			|| PeriodMillis[Tier - 1] < fullPeriod)
+		{
+			return fullPeriod;
+		}
+
+		return PeriodMillis[Tier - 1];
+	}
+};
+#endif
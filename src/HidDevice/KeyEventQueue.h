@@ -0,0 +1,146 @@
+// KeyEventQueue.h
+
+#ifndef _KEY_EVENT_QUEUE_h
+#define _KEY_EVENT_QUEUE_h
+
+#include <stdint.h>
+
+/// <summary>
+/// Single key transition, with capture timestamp.
+/// Modifiers use their HID usage codes [0xE0 ; 0xE7].
+/// </summary>
+struct KeyEventStruct
+{
+	uint32_t Timestamp;
+	uint8_t KeyCode;
+	bool Down;
+};
+
+/// <summary>
+/// Key event queue counters.
+/// </summary>
+struct KeyEventStatsStruct
+{
+	/// <summary>
+	/// Events dropped because the queue was full.
+	/// </summary>
+	uint32_t Overflows = 0;
+
+	/// <summary>
+	/// Presses dropped because the report had no free key slot.
+	/// </summary>
+	uint32_t Rollovers = 0;
+
+	/// <summary>
+	/// Highest queue occupancy seen.
+	/// </summary>
+	uint8_t HighWater = 0;
+};
+
+/// <summary>
+/// Bounded, allocation-free FIFO of key events.
+/// </summary>
+/// <typeparam name="Capacity">Maximum queued events, power of 2 [2 ; 128].</typeparam>
+template<uint8_t Capacity>
+class KeyEventQueue
+{
+private:
+	static_assert(Capacity >= 2 && Capacity <= 128 && ((Capacity & (Capacity - 1)) == 0), "Capacity must be a power of 2 [2 ; 128].");
+
+	static constexpr uint8_t IndexMask = Capacity - 1;
+
+private:
+	KeyEventStruct Events[Capacity]{};
+	uint8_t Head = 0;
+	uint8_t Count = 0;
+
+private:
+	KeyEventStatsStruct Stats{};
+
+public:
+	void Clear()
+	{
+		Head = 0;
+		Count = 0;
+	}
+
+	const uint8_t GetCount() const
+	{
+		return Count;
+	}
+
+	const bool IsEmpty() const
+	{
+		return Count == 0;
+	}
+
+	/// <summary>
+	/// Queue a key event, dropped and counted if the queue is full.
+	/// </summary>
+	/// <returns>False on overflow.</returns>
+	const bool Push(const uint8_t keyCode, const bool down, const uint32_t timestamp)
+	{
+		if (Count >= Capacity)
+		{
+			Stats.Overflows++;
+			return false;
+		}
+
+		KeyEventStruct& event = Events[(Head + Count) & IndexMask];
+		event.Timestamp = timestamp;
+		event.KeyCode = keyCode;
+		event.Down = down;
+		Count++;
+
+		if (Count > Stats.HighWater)
+		{
+			Stats.HighWater = Count;
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Get the queued event at offset from the oldest, without removing it.
+	/// </summary>
+	/// <param name="offset">[0 ; GetCount()-1]</param>
+	const KeyEventStruct& Peek(const uint8_t offset) const
+	{
+		return Events[(Head + offset) & IndexMask];
+	}
+
+	/// <summary>
+	/// Remove the oldest events.
+	/// </summary>
+	void Pop(const uint8_t count)
+	{
+		if (count >= Count)
+		{
+			Clear();
+		}
+		else
+		{
+			Head = (Head + count) & IndexMask;
+			Count -= count;
+		}
+	}
+
+	/// <summary>
+	/// Presses dropped from a sent report.
+	/// </summary>
+	void OnRollover(const uint8_t count)
+	{
+		Stats.Rollovers += count;
+	}
+
+	void GetStats(KeyEventStatsStruct& stats) const
+	{
+		stats = Stats;
+	}
+
+	void ClearStats()
+	{
+		Stats = {};
+	}
+};
+#endif
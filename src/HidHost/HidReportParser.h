@@ -0,0 +1,679 @@
+// HidReportParser.h
+
+#ifndef _HID_REPORT_PARSER_h
+#define _HID_REPORT_PARSER_h
+
+#include <stdint.h>
+
+/// <summary>
+/// HID report descriptor, compiled into a flat extraction program for VirtualPad.
+/// The descriptor is parsed once on connection, notifications only run the program.
+/// </summary>
+namespace HidReport
+{
+	/// <summary>
+	/// VirtualPad field written by a program entry.
+	/// </summary>
+	enum class TargetEnum : uint8_t
+	{
+		None,
+		Joy1X,
+		Joy1Y,
+		Joy2X,
+		Joy2Y,
+		L2,
+		R2,
+		DPad,
+		A,
+		B,
+		X,
+		Y,
+		L1,
+		R1,
+		L2Digital,
+		R2Digital,
+		L3,
+		R3,
+		Start,
+		Select,
+		Home,
+		Share
+	};
+
+	/// <summary>
+	/// Single report field.
+	/// </summary>
+	struct FieldStruct
+	{
+		int32_t LogicalMin;
+		int32_t LogicalMax;
+
+		/// <summary>
+		/// 16.16 scale from the logical range to [0 ; UINT16_MAX], precomputed for analog fields.
+		/// </summary>
+		uint32_t Scale;
+
+		uint16_t BitOffset;
+		uint8_t BitSize;
+		TargetEnum Target;
+	};
+
+	/// <summary>
+	/// Compiled extraction program for one input report.
+	/// </summary>
+	struct ProgramStruct
+	{
+		static constexpr uint8_t MaxFields = 24;
+
+		FieldStruct Fields[MaxFields];
+
+		/// <summary>
+		/// Minimum notification size to run the program, in bytes.
+		/// </summary>
+		uint16_t ReportSize;
+
+		/// <summary>
+		/// Selected input report, 0 if the descriptor doesn't use IDs.
+		/// </summary>
+		uint8_t ReportId;
+
+		uint8_t Count;
+	};
+
+	/// <summary>
+	/// Raw field read, little endian and bit aligned.
+	/// Bounds are checked once per report against ProgramStruct::ReportSize.
+	/// </summary>
+	inline const int32_t Extract(const uint8_t* data, const FieldStruct& field)
+	{
+		const uint8_t* source = &data[field.BitOffset >> 3];
+		const uint8_t shift = field.BitOffset & 7;
+		const uint8_t bytes = (shift + field.BitSize + 7) >> 3;
+
+		uint64_t word = 0;
+		for (uint8_t i = 0; i < bytes; i++)
+		{
+			word |= (uint64_t)source[i] << (i * 8);
+		}
+
+		const uint32_t raw = (uint32_t)(word >> shift) & (uint32_t)(((uint64_t)1 << field.BitSize) - 1);
+
+		if (field.LogicalMin < 0
+			&& field.BitSize < 32
+			&& ((raw >> (field.BitSize - 1)) & 1))
+		{
+			// Sign extend.
+			return (int32_t)(raw | ~(uint32_t)(((uint64_t)1 << field.BitSize) - 1));
+		}
+
+		return (int32_t)raw;
+	}
+
+	/// <summary>
+	/// Analog field value, clamped and scaled to [0 ; UINT16_MAX].
+	/// </summary>
+	inline const uint16_t GetUnsigned(const FieldStruct& field, const int32_t value)
+	{
+		if (value <= field.LogicalMin)
+		{
+			return 0;
+		}
+		else if (value >= field.LogicalMax)
+		{
+			return UINT16_MAX;
+		}
+
+		return (uint16_t)(((uint64_t)(uint32_t)(value - field.LogicalMin) * field.Scale) >> 16);
+	}
+
+	/// <summary>
+	/// Hat switch value, out of range is the null state.
+	/// </summary>
+	/// <returns>VirtualPad DPadEnum value, 0 for centered.</returns>
+	inline const uint8_t GetHat(const FieldStruct& field, const int32_t value)
+	{
+		if (value < field.LogicalMin
+			|| value > field.LogicalMax)
+		{
+			return 0;
+		}
+
+		const uint8_t position = value - field.LogicalMin;
+		if ((field.LogicalMax - field.LogicalMin) == 3)
+		{
+			// 4-way hat, cardinal directions only.
+			return 1 + (position * 2);
+		}
+
+		return 1 + position;
+	}
+
+	/// <summary>
+	/// Report descriptor compiler.
+	/// Only the first Gamepad or Joystick application collection is compiled,
+	/// using the first input report inside it.
+	/// Variable input items are mapped by usage:
+	///		Generic Desktop X/Y - Joy1.
+	///		Generic Desktop Z/Rz - Joy2.
+	///		Generic Desktop Rx/Ry - Triggers, or Joy2 if Z/Rz aren't present.
+	///		Simulation Brake/Accelerator - Triggers.
+	///		Generic Desktop Hat Switch - DPad.
+	///		Button 1-15 - Linux/Android gamepad order (A, B, C, X, Y, Z, L1, R1, L2, R2, Select, Start, Home, L3, R3).
+	///		Consumer AC Back/AC Home/Record - Select/Home/Share.
+	/// Array items, outputs and features are skipped.
+	/// </summary>
+	class Parser
+	{
+	private:
+		enum class ItemTypeEnum : uint8_t
+		{
+			Main = 0,
+			Global = 1,
+			Local = 2
+		};
+
+		enum class MainTagEnum : uint8_t
+		{
+			Input = 0x8,
+			Collection = 0xA,
+			EndCollection = 0xC
+		};
+
+		enum class GlobalTagEnum : uint8_t
+		{
+			UsagePage = 0x0,
+			LogicalMin = 0x1,
+			LogicalMax = 0x2,
+			ReportSize = 0x7,
+			ReportId = 0x8,
+			ReportCount = 0x9,
+			Push = 0xA,
+			Pop = 0xB
+		};
+
+		enum class LocalTagEnum : uint8_t
+		{
+			Usage = 0x0,
+			UsageMin = 0x1,
+			UsageMax = 0x2
+		};
+
+		enum class UsagePageEnum : uint16_t
+		{
+			GenericDesktop = 0x01,
+			Simulation = 0x02,
+			Button = 0x09,
+			Consumer = 0x0C
+		};
+
+		static constexpr uint8_t LongItemPrefix = 0xFE;
+		static constexpr uint8_t CollectionApplication = 0x01;
+		static constexpr uint8_t InputConstant = 0x01;
+		static constexpr uint8_t InputVariable = 0x02;
+		static constexpr uint8_t StackSize = 2;
+		static constexpr uint8_t MaxUsages = 16;
+		static constexpr uint32_t UsageRx = 0x00010033;
+		static constexpr uint32_t UsageRy = 0x00010034;
+
+		struct GlobalStruct
+		{
+			int32_t LogicalMin;
+			int32_t LogicalMax;
+			uint16_t UsagePage;
+			uint8_t ReportSize;
+			uint8_t ReportCount;
+			uint8_t ReportId;
+			bool LogicalMaxUnsigned;
+		};
+
+	private:
+		GlobalStruct Global{};
+		GlobalStruct Stack[StackSize]{};
+		uint8_t StackCount = 0;
+
+		uint32_t Usages[MaxUsages]{};
+		uint32_t UsageMin = 0;
+		uint32_t UsageMax = 0;
+		uint8_t UsageCount = 0;
+		bool UsageRange = false;
+
+		uint16_t BitOffset = 0;
+		uint8_t RxField = UINT8_MAX;
+		uint8_t RyField = UINT8_MAX;
+		uint8_t Depth = 0;
+		uint8_t ApplicationDepth = 0;
+		bool ReportSelected = false;
+		bool ApplicationDone = false;
+
+	public:
+		/// <summary>
+		/// Compile the descriptor into the program.
+		/// </summary>
+		/// <returns>False if no gamepad fields were found.</returns>
+		static const bool Compile(const uint8_t* descriptor, const uint16_t size, ProgramStruct& program)
+		{
+			Parser parser{};
+
+			program = {};
+
+			return descriptor != nullptr
+				&& parser.Parse(descriptor, size, program)
+				&& parser.Resolve(program);
+		}
+
+	private:
+		const bool Parse(const uint8_t* descriptor, const uint16_t size, ProgramStruct& program)
+		{
+			uint16_t index = 0;
+			while (index < size)
+			{
+				const uint8_t prefix = descriptor[index++];
+
+				if (prefix == LongItemPrefix)
+				{
+					// Long items carry no gamepad data, skip them.
+					if (index >= size)
+					{
+						return false;
+					}
+					index += 2 + descriptor[index];
+					continue;
+				}
+
+				const uint8_t dataSize = (prefix & 0x03) == 3 ? 4 : (prefix & 0x03);
+				if ((index + dataSize) > size)
+				{
+					return false;
+				}
+
+				uint32_t data = 0;
+				for (uint8_t i = 0; i < dataSize; i++)
+				{
+					data |= (uint32_t)descriptor[index + i] << (i * 8);
+				}
+				index += dataSize;
+
+				const uint8_t tag = prefix >> 4;
+				switch ((ItemTypeEnum)((prefix >> 2) & 0x03))
+				{
+				case ItemTypeEnum::Main:
+					OnMain(tag, data, program);
+					ClearLocal();
+					break;
+				case ItemTypeEnum::Global:
+					OnGlobal(tag, data, dataSize);
+					break;
+				case ItemTypeEnum::Local:
+					OnLocal(tag, data, dataSize);
+					break;
+				default:
+					break;
+				}
+			}
+
+			program.ReportSize = (BitOffset + 7) >> 3;
+
+			return program.Count > 0;
+		}
+
+		void OnMain(const uint8_t tag, const uint32_t data, ProgramStruct& program)
+		{
+			switch ((MainTagEnum)tag)
+			{
+			case MainTagEnum::Collection:
+				Depth++;
+				if (ApplicationDepth == 0
+					&& !ApplicationDone
+					&& (uint8_t)data == CollectionApplication
+					&& UsageCount > 0
+					&& IsGamepadApplication(Usages[0]))
+				{
+					ApplicationDepth = Depth;
+				}
+				break;
+			case MainTagEnum::EndCollection:
+				if (ApplicationDepth != 0
+					&& Depth == ApplicationDepth)
+				{
+					ApplicationDepth = 0;
+					ApplicationDone = true;
+				}
+				if (Depth > 0)
+				{
+					Depth--;
+				}
+				break;
+			case MainTagEnum::Input:
+				if (ApplicationDepth != 0)
+				{
+					OnInput((uint8_t)data, program);
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		void OnInput(const uint8_t flags, ProgramStruct& program)
+		{
+			if (!ReportSelected)
+			{
+				ReportSelected = true;
+				program.ReportId = Global.ReportId;
+			}
+			else if (Global.ReportId != program.ReportId)
+			{
+				// Other reports have their own offsets.
+				return;
+			}
+
+			if ((flags & InputConstant) == 0
+				&& (flags & InputVariable) != 0
+				&& Global.ReportSize > 0
+				&& Global.ReportSize <= 32)
+			{
+				for (uint8_t i = 0; i < Global.ReportCount; i++)
+				{
+					const uint32_t usage = GetUsage(i);
+					const TargetEnum target = GetTarget(usage);
+
+					if (target != TargetEnum::None
+						&& program.Count < ProgramStruct::MaxFields)
+					{
+						if (usage == UsageRx)
+						{
+							RxField = program.Count;
+						}
+						else if (usage == UsageRy)
+						{
+							RyField = program.Count;
+						}
+
+						FieldStruct& field = program.Fields[program.Count++];
+						field.BitOffset = BitOffset + ((uint16_t)i * Global.ReportSize);
+						field.BitSize = Global.ReportSize;
+						field.Target = target;
+						field.LogicalMin = Global.LogicalMin;
+						field.LogicalMax = Global.LogicalMax;
+						if (field.LogicalMax < field.LogicalMin
+							|| (Global.LogicalMaxUnsigned && field.LogicalMin >= 0))
+						{
+							// Common descriptor mistake, unsigned maximum in a signed item.
+							field.LogicalMax = (int32_t)(((uint64_t)1 << (Global.ReportSize < 31 ? Global.ReportSize : 31)) - 1);
+						}
+					}
+				}
+			}
+
+			BitOffset += (uint16_t)Global.ReportSize * Global.ReportCount;
+		}
+
+		void OnGlobal(const uint8_t tag, const uint32_t data, const uint8_t dataSize)
+		{
+			switch ((GlobalTagEnum)tag)
+			{
+			case GlobalTagEnum::UsagePage:
+				Global.UsagePage = (uint16_t)data;
+				break;
+			case GlobalTagEnum::LogicalMin:
+				Global.LogicalMin = SignExtend(data, dataSize);
+				break;
+			case GlobalTagEnum::LogicalMax:
+				Global.LogicalMax = SignExtend(data, dataSize);
+				Global.LogicalMaxUnsigned = Global.LogicalMax < 0;
+				break;
+			case GlobalTagEnum::ReportSize:
+				Global.ReportSize = (uint8_t)data;
+				break;
+			case GlobalTagEnum::ReportId:
+				Global.ReportId = (uint8_t)data;
+				break;
+			case GlobalTagEnum::ReportCount:
+				Global.ReportCount = (uint8_t)data;
+				break;
+			case GlobalTagEnum::Push:
+				if (StackCount < StackSize)
+				{
+					Stack[StackCount++] = Global;
+				}
+				break;
+			case GlobalTagEnum::Pop:
+				if (StackCount > 0)
+				{
+					Global = Stack[--StackCount];
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		void OnLocal(const uint8_t tag, const uint32_t data, const uint8_t dataSize)
+		{
+			// Short usages are on the current page.
+			const uint32_t usage = dataSize == 4 ? data : (((uint32_t)Global.UsagePage << 16) | data);
+
+			switch ((LocalTagEnum)tag)
+			{
+			case LocalTagEnum::Usage:
+				if (UsageCount < MaxUsages)
+				{
+					Usages[UsageCount++] = usage;
+				}
+				break;
+			case LocalTagEnum::UsageMin:
+				UsageMin = usage;
+				UsageRange = true;
+				break;
+			case LocalTagEnum::UsageMax:
+				UsageMax = usage;
+				UsageRange = true;
+				break;
+			default:
+				break;
+			}
+		}
+
+		void ClearLocal()
+		{
+			UsageCount = 0;
+			UsageMin = 0;
+			UsageMax = 0;
+			UsageRange = false;
+		}
+
+		const uint32_t GetUsage(const uint8_t index) const
+		{
+			if (UsageCount > 0)
+			{
+				// The last usage repeats for the remaining fields.
+				return Usages[index < UsageCount ? index : UsageCount - 1];
+			}
+			else if (UsageRange
+				&& (UsageMin + index) <= UsageMax)
+			{
+				return UsageMin + index;
+			}
+
+			return 0;
+		}
+
+		/// <summary>
+		/// Rx/Ry are triggers on pads that use Z/Rz for the right stick,
+		/// otherwise they are the right stick.
+		/// L2/R2 buttons are dropped when analog triggers are present.
+		/// Analog scales are precomputed here.
+		/// </summary>
+		const bool Resolve(ProgramStruct& program) const
+		{
+			bool hasJoy2X = false;
+			bool hasJoy2Y = false;
+			for (uint8_t i = 0; i < program.Count; i++)
+			{
+				hasJoy2X |= program.Fields[i].Target == TargetEnum::Joy2X;
+				hasJoy2Y |= program.Fields[i].Target == TargetEnum::Joy2Y;
+			}
+
+			if (RxField < program.Count && !hasJoy2X)
+			{
+				program.Fields[RxField].Target = TargetEnum::Joy2X;
+			}
+
+			if (RyField < program.Count && !hasJoy2Y)
+			{
+				program.Fields[RyField].Target = TargetEnum::Joy2Y;
+			}
+
+			bool analogL2 = false;
+			bool analogR2 = false;
+			for (uint8_t i = 0; i < program.Count; i++)
+			{
+				analogL2 |= program.Fields[i].Target == TargetEnum::L2;
+				analogR2 |= program.Fields[i].Target == TargetEnum::R2;
+			}
+
+			uint8_t count = 0;
+			for (uint8_t i = 0; i < program.Count; i++)
+			{
+				FieldStruct field = program.Fields[i];
+				if ((field.Target == TargetEnum::L2Digital && analogL2)
+					|| (field.Target == TargetEnum::R2Digital && analogR2))
+				{
+					continue;
+				}
+
+				if (IsAnalog(field.Target)
+					&& field.LogicalMax > field.LogicalMin)
+				{
+					field.Scale = (uint32_t)(((uint64_t)UINT16_MAX << 16) / (uint32_t)(field.LogicalMax - field.LogicalMin));
+				}
+				else
+				{
+					field.Scale = 0;
+				}
+
+				program.Fields[count++] = field;
+			}
+			program.Count = count;
+
+			return count > 0;
+		}
+
+		static const TargetEnum GetTarget(const uint32_t usage)
+		{
+			const uint16_t id = usage & UINT16_MAX;
+
+			switch ((UsagePageEnum)(usage >> 16))
+			{
+			case UsagePageEnum::GenericDesktop:
+				switch (id)
+				{
+				case 0x30:
+					return TargetEnum::Joy1X;
+				case 0x31:
+					return TargetEnum::Joy1Y;
+				case 0x32:
+					return TargetEnum::Joy2X;
+				case 0x35:
+					return TargetEnum::Joy2Y;
+				case 0x33: // Rx, see Resolve.
+					return TargetEnum::L2;
+				case 0x34: // Ry, see Resolve.
+					return TargetEnum::R2;
+				case 0x39:
+					return TargetEnum::DPad;
+				default:
+					return TargetEnum::None;
+				}
+			case UsagePageEnum::Simulation:
+				switch (id)
+				{
+				case 0xC5:
+					return TargetEnum::L2;
+				case 0xC4:
+					return TargetEnum::R2;
+				default:
+					return TargetEnum::None;
+				}
+			case UsagePageEnum::Button:
+				return GetButtonTarget(id);
+			case UsagePageEnum::Consumer:
+				switch (id)
+				{
+				case 0x224:
+					return TargetEnum::Select;
+				case 0x223:
+					return TargetEnum::Home;
+				case 0xB2:
+					return TargetEnum::Share;
+				default:
+					return TargetEnum::None;
+				}
+			default:
+				return TargetEnum::None;
+			}
+		}
+
+		static const TargetEnum GetButtonTarget(const uint16_t button)
+		{
+			static constexpr TargetEnum Order[] =
+			{
+				TargetEnum::A,
+				TargetEnum::B,
+				TargetEnum::None, // C
+				TargetEnum::X,
+				TargetEnum::Y,
+				TargetEnum::None, // Z
+				TargetEnum::L1,
+				TargetEnum::R1,
+				TargetEnum::L2Digital,
+				TargetEnum::R2Digital,
+				TargetEnum::Select,
+				TargetEnum::Start,
+				TargetEnum::Home,
+				TargetEnum::L3,
+				TargetEnum::R3
+			};
+
+			if (button >= 1
+				&& button <= (sizeof(Order) / sizeof(Order[0])))
+			{
+				return Order[button - 1];
+			}
+
+			return TargetEnum::None;
+		}
+
+		static constexpr bool IsAnalog(const TargetEnum target)
+		{
+			return target == TargetEnum::Joy1X
+				|| target == TargetEnum::Joy1Y
+				|| target == TargetEnum::Joy2X
+				|| target == TargetEnum::Joy2Y
+				|| target == TargetEnum::L2
+				|| target == TargetEnum::R2;
+		}
+
+		static constexpr bool IsGamepadApplication(const uint32_t usage)
+		{
+			// Generic Desktop Joystick or Gamepad.
+			return usage == 0x00010004 || usage == 0x00010005;
+		}
+
+		static const int32_t SignExtend(const uint32_t data, const uint8_t dataSize)
+		{
+			switch (dataSize)
+			{
+			case 1:
+				return (int8_t)data;
+			case 2:
+				return (int16_t)data;
+			case 4:
+				return (int32_t)data;
+			default:
+				return 0;
+			}
+		}
+	};
+}
+#endif
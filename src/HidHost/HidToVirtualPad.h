@@ -3,20 +3,31 @@
 
 #include <VirtualPad.h>
 
-#include "../Ble/BleCentral.h"
+#include "../Ble/IHidListener.h"
+#include "../Framework/SpscMailbox.h"
+#include "../Analog/AnalogProcessor.h"
+#include "../Analog/AxisKernels.h"
+#include "../PadBridge/PadState.h"
 #include "XBoxControllerHid.h"
+#include "HidReportParser.h"
 
 
-enum class HidMapTypeEnum : uint16_t
+enum class HidMapTypeEnum : uint8_t
 {
-	XBox = 10829,
-	// TODO:
-	GenericGamepad = 0
+	XBox,
+	GenericGamepad
 };
 
 
 /// <summary>
 /// HID source controller, mapped to Virtual Pad.
+/// The mapping is matched by the report map, the report UUID is the same for every controller.
+/// A report map with the XBox layout uses the fixed XBox mapping, any other compiled report map runs its extraction program.
+/// Without a report map, the fixed XBox mapping is kept.
+/// Notifications are mapped in the BLE callback context into a latest-wins state mailbox,
+/// Update() applies the latest state to the Virtual Pad from the consumer context.
+/// Disconnections are counted apart, so a superseded disconnected state is still applied.
+/// Sticks and triggers go through the analog stage before being queued.
 /// </summary>
 template<uint32_t hidConfigurationCode>
 class HidToVirtualPad : public virtual IHidListener, public VirtualPad::AnalogVirtualPad<hidConfigurationCode>
@@ -24,6 +35,26 @@ class HidToVirtualPad : public virtual IHidListener, public VirtualPad::AnalogVi
 private:
 	using Base = VirtualPad::AnalogVirtualPad<hidConfigurationCode>;
 
+	using PadStateStruct = PadBridge::PadStateStruct;
+	using ButtonEnum = PadBridge::ButtonEnum;
+
+private:
+	HidReport::ProgramStruct Program{};
+	HidMapTypeEnum MapType = HidMapTypeEnum::XBox;
+
+private:
+	SpscMailbox<PadStateStruct> States{};
+	uint32_t Overruns = 0;
+
+	std::atomic<uint8_t> Disconnects{ 0 };
+	uint8_t LastDisconnects = 0;
+
+private:
+	AnalogProcessor::Stick Joy1Stage{ GetDefaultStickProfile() };
+	AnalogProcessor::Stick Joy2Stage{ GetDefaultStickProfile() };
+	AnalogProcessor::Trigger L2Stage{};
+	AnalogProcessor::Trigger R2Stage{};
+
 public:
 	HidToVirtualPad()
 		: IHidListener()
@@ -31,119 +62,455 @@ public:
 	{
 	}
 
+	/// <summary>
+	/// Consumer side, apply the latest notified state.
+	/// The Virtual Pad is only written here, so reads from the same context are always consistent.
+	/// </summary>
+	/// <returns>True if the state was updated.</returns>
+	const bool Update()
+	{
+		const PadStateStruct* state = States.Take();
+
+		// Read after the state, a state taken after a disconnection always sees it counted.
+		const uint8_t disconnects = Disconnects.load(std::memory_order_acquire);
+		const bool disconnected = disconnects != LastDisconnects;
+		if (disconnected)
+		{
+			LastDisconnects = disconnects;
+			ApplyDisconnect();
+		}
+
+		if (state == nullptr)
+		{
+			return disconnected;
+		}
+
+		ApplyState(*state);
+
+		return true;
+	}
+
+	/// <summary>
+	/// Set before the controller connects.
+	/// </summary>
+	void SetStickProfile(const AnalogProcessor::StickProfileStruct& joy1, const AnalogProcessor::StickProfileStruct& joy2)
+	{
+		Joy1Stage.SetProfile(joy1);
+		Joy2Stage.SetProfile(joy2);
+	}
+
+	/// <summary>
+	/// Set before the controller connects.
+	/// </summary>
+	void SetTriggerProfile(const AnalogProcessor::TriggerProfileStruct& l2, const AnalogProcessor::TriggerProfileStruct& r2)
+	{
+		L2Stage.SetProfile(l2);
+		R2Stage.SetProfile(r2);
+	}
+
+	/// <summary>
+	/// States superseded before the consumer took them.
+	/// </summary>
+	const uint32_t GetOverruns() const
+	{
+		return Overruns;
+	}
+
 public:
 	virtual void OnStateChange(const bool connected)
 	{
-		if (Base::Connected() != connected)
+		if (!connected)
 		{
-			Base::Clear();
-			Base::SetConnected(connected);
+			// Next controller may have another report map.
+			Program.Count = 0;
+			MapType = HidMapTypeEnum::XBox;
+			Disconnects.fetch_add(1, std::memory_order_release);
 		}
+
+		PadStateStruct& state = States.Reserve();
+		state = {};
+		state.Flags = (uint8_t)connected << (uint8_t)PadBridge::StateFlagEnum::Connected;
+		Commit();
 	}
 
+	/// <summary>
+	/// Compile the report map into the extraction program, once per connection.
+	/// </summary>
+	virtual void OnReportMap(const uint8_t* data, const uint16_t size) final
+	{
+		const bool compiled = HidReport::Parser::Compile(data, size, Program);
+
 #if defined(DEBUG)
-	uint16_t LastUuid = UINT16_MAX;
+		if (compiled)
+		{
+			Serial.print(F("Report map compiled: "));
+			Serial.print(Program.Count);
+			Serial.print(F(" fields, "));
+			Serial.print(Program.ReportSize);
+			Serial.println(F(" bytes"));
+		}
+		else
+		{
+			Serial.println(F("Report map not supported."));
+		}
 #endif
+		if (!compiled)
+		{
+			Program.Count = 0;
+		}
+
+		SelectMap();
+	}
+
+	virtual void OnReportProgram(const HidReport::ProgramStruct& program) final
+	{
+		Program = program;
+		SelectMap();
+	}
+
+	virtual const bool GetReportProgram(HidReport::ProgramStruct& program) final
+	{
+		if (Program.Count > 0)
+		{
+			program = Program;
+			return true;
+		}
+
+		return false;
+	}
 
 	/// <summary>
-	/// Dynamically maps the report data to VirtualPad, matched by the UUID.
+	/// Dynamically maps the report data to VirtualPad, with the mapping selected from the report map.
+	/// The report is mapped straight into the mailbox slot.
 	/// </summary>
 	/// <param name="data"></param>
 	/// <param name="size"></param>
 	/// <param name="uuid"></param>
 	virtual void OnControllerNotify(uint8_t* data, const uint16_t size, const uint16_t uuid) final
 	{
+		PadStateStruct& state = States.Reserve();
+
+		bool mapped = false;
 		if (data != nullptr)
 		{
-#if defined(DEBUG)
-			if (LastUuid != uuid)
-			{
-				LastUuid = uuid;
-				Serial.print(F("\tProfile switched to \t"));
-				Serial.println(uuid);
-			}
-#endif
-
-			// Check for UUID match.
-			switch ((HidMapTypeEnum)uuid)
+			switch (MapType)
 			{
 			case HidMapTypeEnum::XBox:
-				HidMapXBox(data, size);
+				mapped = HidMapXBox(data, size, state);
 				break;
 			case HidMapTypeEnum::GenericGamepad:
 			default:
-				HidMapGenericGamepad(data, size);
+				mapped = HidMapGenericGamepad(data, size, state);
 				break;
 			}
 		}
 		else
 		{
-			Base::SetConnected(false);
+			state = {};
+			mapped = true;
+		}
+
+		if (mapped)
+		{
+			ProcessAnalog(state);
+			Commit();
 		}
 	}
 
+	const HidMapTypeEnum GetMapType() const
+	{
+		return MapType;
+	}
+
 private:
-	// TODO
-	void HidMapGenericGamepad(uint8_t* data, const uint16_t len)
+	/// <summary>
+	/// Known layouts keep their fixed mapping, other report maps run the compiled program.
+	/// </summary>
+	void SelectMap()
+	{
+		if (Program.Count > 0
+			&& !XBoxControllerHid::MatchesProgram(Program))
+		{
+			MapType = HidMapTypeEnum::GenericGamepad;
+		}
+		else
+		{
+			MapType = HidMapTypeEnum::XBox;
+		}
+
+#if defined(DEBUG)
+		Serial.print(F("\tProfile switched to \t"));
+		if (MapType == HidMapTypeEnum::XBox)
+		{
+			Serial.println(F("XBox"));
+		}
+		else
+		{
+			Serial.println(F("Generic"));
+		}
+#endif
+	}
+
+	void Commit()
+	{
+		if (!States.Commit())
+		{
+			Overruns++;
+		}
+	}
+
+	void ApplyDisconnect()
 	{
 		if (Base::Connected())
 		{
+			Base::Clear();
 			Base::SetConnected(false);
 		}
 	}
 
-	void HidMapXBox(uint8_t* data, const uint16_t len)
+	void ProcessAnalog(PadStateStruct& state) const
+	{
+		// The state is packed, process on aligned copies.
+		int16_t x1 = state.Joy1X, y1 = state.Joy1Y;
+		int16_t x2 = state.Joy2X, y2 = state.Joy2Y;
+		Joy1Stage.Process(x1, y1);
+		Joy2Stage.Process(x2, y2);
+		state.Joy1X = x1;
+		state.Joy1Y = y1;
+		state.Joy2X = x2;
+		state.Joy2Y = y2;
+		state.L2 = L2Stage.Process(state.L2);
+		state.R2 = R2Stage.Process(state.R2);
+	}
+
+	static const AnalogProcessor::StickProfileStruct GetDefaultStickProfile()
+	{
+		AnalogProcessor::StickProfileStruct profile{};
+		profile.Deadzone = XBoxControllerHid::JoyStickDeadZone;
+
+		return profile;
+	}
+
+	void ApplyState(const PadStateStruct& state)
 	{
-		if (len >= XBoxControllerHid::DataSize)
-		{
-			// Bit aligned conversion.
-			const int16_t x1 = (data[0] | (uint16_t)data[1] << 8) + (uint16_t)INT16_MAX + 1;
-			const int16_t y1 = -((data[2] | (uint16_t)data[3] << 8) - (uint16_t)INT16_MAX);
-			const int16_t x2 = (data[4] | (uint16_t)data[5] << 8) - (uint16_t)INT16_MAX - 1;
-			const int16_t y2 = -((data[6] | (uint16_t)data[7] << 8) - (uint16_t)INT16_MAX);
-			Base::SetJoy1(x1, y1);
-			Base::SetJoy2(x2, y2);
-
-			// Scale to uint16_t full range.
-			const uint16_t l2 = ((uint32_t)(data[8] | (uint16_t)data[9] << 8) * UINT16_MAX) / XBoxControllerHid::TriggerMax;
-			const uint16_t r2 = ((uint32_t)(data[10] | (uint16_t)data[11] << 8) * UINT16_MAX) / XBoxControllerHid::TriggerMax;
-			Base::SetL2(l2);
-			Base::SetR2(r2);
-
-			// Virtual Pad DPadEnum is derived from HID DPad and is compatible with XBox mapping.
-			Base::dPad = VirtualPad::DPadEnum(data[12]);
-
-			// First byte of buttons.
-			const uint8_t buttons1 = data[13];
-			Base::SetA(GetButton<(uint8_t)XBoxControllerHid::Buttons1::A>(buttons1));
-			Base::SetB(GetButton<(uint8_t)XBoxControllerHid::Buttons1::B>(buttons1));
-			Base::SetX(GetButton<(uint8_t)XBoxControllerHid::Buttons1::X>(buttons1));
-			Base::SetY(GetButton<(uint8_t)XBoxControllerHid::Buttons1::Y>(buttons1));
-			Base::SetL1(GetButton<(uint8_t)XBoxControllerHid::Buttons1::L1>(buttons1));
-			Base::SetR1(GetButton<(uint8_t)XBoxControllerHid::Buttons1::R1>(buttons1));
-
-			// Second byte of buttons.
-			const uint8_t buttons2 = data[14];
-			Base::SetSelect(GetButton<(uint8_t)XBoxControllerHid::Buttons2::Select>(buttons2));
-			Base::SetStart(GetButton<(uint8_t)XBoxControllerHid::Buttons2::Start>(buttons2));
-			Base::SetL3(GetButton<(uint8_t)XBoxControllerHid::Buttons2::L3>(buttons2));
-			Base::SetR3(GetButton<(uint8_t)XBoxControllerHid::Buttons2::R3>(buttons2));
-			Base::SetHome(GetButton<(uint8_t)XBoxControllerHid::Buttons2::Home>(buttons2));
-
-			// Third byte of buttons.
-			const uint8_t buttons3 = data[15];
-			Base::SetShare(GetButton<(uint8_t)XBoxControllerHid::Buttons3::Share>(buttons3));
-
-			if (!Base::Connected())
+		const bool connected = (state.Flags >> (uint8_t)PadBridge::StateFlagEnum::Connected) & 1;
+
+		if (!connected)
+		{
+			ApplyDisconnect();
+			return;
+		}
+
+		Base::SetJoy1(state.Joy1X, state.Joy1Y);
+		Base::SetJoy2(state.Joy2X, state.Joy2Y);
+		Base::SetL2(state.L2);
+		Base::SetR2(state.R2);
+
+		// Virtual Pad DPadEnum is derived from HID DPad.
+		Base::dPad = VirtualPad::DPadEnum(state.DPad);
+
+		Base::SetA(GetButton<(uint8_t)ButtonEnum::A>(state.Buttons));
+		Base::SetB(GetButton<(uint8_t)ButtonEnum::B>(state.Buttons));
+		Base::SetX(GetButton<(uint8_t)ButtonEnum::X>(state.Buttons));
+		Base::SetY(GetButton<(uint8_t)ButtonEnum::Y>(state.Buttons));
+		Base::SetL1(GetButton<(uint8_t)ButtonEnum::L1>(state.Buttons));
+		Base::SetR1(GetButton<(uint8_t)ButtonEnum::R1>(state.Buttons));
+		Base::SetL3(GetButton<(uint8_t)ButtonEnum::L3>(state.Buttons));
+		Base::SetR3(GetButton<(uint8_t)ButtonEnum::R3>(state.Buttons));
+		Base::SetStart(GetButton<(uint8_t)ButtonEnum::Start>(state.Buttons));
+		Base::SetSelect(GetButton<(uint8_t)ButtonEnum::Select>(state.Buttons));
+		Base::SetHome(GetButton<(uint8_t)ButtonEnum::Home>(state.Buttons));
+		Base::SetShare(GetButton<(uint8_t)ButtonEnum::Share>(state.Buttons));
+
+		if (!Base::Connected())
+		{
+			Base::SetConnected(true);
+		}
+	}
+
+	/// <summary>
+	/// Runs the compiled extraction program over the report.
+	/// Disconnected if there's no program for this controller.
+	/// </summary>
+	/// <returns>False if the report is too short.</returns>
+	const bool HidMapGenericGamepad(uint8_t* data, const uint16_t len, PadStateStruct& state)
+	{
+		state = {};
+
+		if (Program.Count == 0)
+		{
+			return true;
+		}
+
+		if (len < Program.ReportSize)
+		{
+			return false;
+		}
+
+		bool l2Digital = false, r2Digital = false;
+
+		for (uint8_t i = 0; i < Program.Count; i++)
+		{
+			const HidReport::FieldStruct& field = Program.Fields[i];
+			const int32_t value = HidReport::Extract(data, field);
+
+			switch (field.Target)
 			{
-				Base::SetConnected(true);
+			case HidReport::TargetEnum::Joy1X:
+				state.Joy1X = GetAxis(field, value);
+				break;
+			case HidReport::TargetEnum::Joy1Y:
+				state.Joy1Y = GetAxisInverted(field, value);
+				break;
+			case HidReport::TargetEnum::Joy2X:
+				state.Joy2X = GetAxis(field, value);
+				break;
+			case HidReport::TargetEnum::Joy2Y:
+				state.Joy2Y = GetAxisInverted(field, value);
+				break;
+			case HidReport::TargetEnum::L2:
+				state.L2 = HidReport::GetUnsigned(field, value);
+				break;
+			case HidReport::TargetEnum::R2:
+				state.R2 = HidReport::GetUnsigned(field, value);
+				break;
+			case HidReport::TargetEnum::DPad:
+				state.DPad = HidReport::GetHat(field, value);
+				break;
+			case HidReport::TargetEnum::A:
+				state.Buttons |= GetButtonMask<ButtonEnum::A>(value);
+				break;
+			case HidReport::TargetEnum::B:
+				state.Buttons |= GetButtonMask<ButtonEnum::B>(value);
+				break;
+			case HidReport::TargetEnum::X:
+				state.Buttons |= GetButtonMask<ButtonEnum::X>(value);
+				break;
+			case HidReport::TargetEnum::Y:
+				state.Buttons |= GetButtonMask<ButtonEnum::Y>(value);
+				break;
+			case HidReport::TargetEnum::L1:
+				state.Buttons |= GetButtonMask<ButtonEnum::L1>(value);
+				break;
+			case HidReport::TargetEnum::R1:
+				state.Buttons |= GetButtonMask<ButtonEnum::R1>(value);
+				break;
+			case HidReport::TargetEnum::L2Digital:
+				l2Digital |= value != 0;
+				break;
+			case HidReport::TargetEnum::R2Digital:
+				r2Digital |= value != 0;
+				break;
+			case HidReport::TargetEnum::L3:
+				state.Buttons |= GetButtonMask<ButtonEnum::L3>(value);
+				break;
+			case HidReport::TargetEnum::R3:
+				state.Buttons |= GetButtonMask<ButtonEnum::R3>(value);
+				break;
+			case HidReport::TargetEnum::Start:
+				state.Buttons |= GetButtonMask<ButtonEnum::Start>(value);
+				break;
+			case HidReport::TargetEnum::Select:
+				state.Buttons |= GetButtonMask<ButtonEnum::Select>(value);
+				break;
+			case HidReport::TargetEnum::Home:
+				state.Buttons |= GetButtonMask<ButtonEnum::Home>(value);
+				break;
+			case HidReport::TargetEnum::Share:
+				state.Buttons |= GetButtonMask<ButtonEnum::Share>(value);
+				break;
+			case HidReport::TargetEnum::None:
+			default:
+				break;
 			}
 		}
+
+		if (l2Digital)
+		{
+			state.L2 = UINT16_MAX;
+		}
+
+		if (r2Digital)
+		{
+			state.R2 = UINT16_MAX;
+		}
+
+		state.Flags = 1 << (uint8_t)PadBridge::StateFlagEnum::Connected;
+
+		return true;
+	}
+
+	/// <returns>False if the report is too short.</returns>
+	const bool HidMapXBox(uint8_t* data, const uint16_t len, PadStateStruct& state)
+	{
+		if (len < XBoxControllerHid::DataSize)
+		{
+			return false;
+		}
+
+		// Axis pairs, unsigned to signed and Y inverted.
+		const uint32_t joy1 = AxisKernels::InvertHigh(AxisKernels::FlipBias(AxisKernels::Load(&data[0])));
+		const uint32_t joy2 = AxisKernels::InvertHigh(AxisKernels::FlipBias(AxisKernels::Load(&data[4])));
+		state.Joy1X = AxisKernels::Low(joy1);
+		state.Joy1Y = AxisKernels::High(joy1);
+		state.Joy2X = AxisKernels::Low(joy2);
+		state.Joy2Y = AxisKernels::High(joy2);
+
+		// Trigger pair, scaled to uint16_t full range.
+		const uint32_t triggers = AxisKernels::ScaleUnsigned<XBoxControllerHid::TriggerShift>(AxisKernels::Load(&data[8]), XBoxControllerHid::TriggerScale);
+		state.L2 = triggers & UINT16_MAX;
+		state.R2 = triggers >> 16;
+
+		// Virtual Pad DPadEnum is derived from HID DPad and is compatible with XBox mapping.
+		state.DPad = data[12];
+
+		// First byte of buttons.
+		const uint8_t buttons1 = data[13];
+		// Second byte of buttons.
+		const uint8_t buttons2 = data[14];
+		// Third byte of buttons.
+		const uint8_t buttons3 = data[15];
+
+		state.Buttons = GetButtonMask<ButtonEnum::A>(GetButton<(uint8_t)XBoxControllerHid::Buttons1::A>(buttons1))
+			| GetButtonMask<ButtonEnum::B>(GetButton<(uint8_t)XBoxControllerHid::Buttons1::B>(buttons1))
+			| GetButtonMask<ButtonEnum::X>(GetButton<(uint8_t)XBoxControllerHid::Buttons1::X>(buttons1))
+			| GetButtonMask<ButtonEnum::Y>(GetButton<(uint8_t)XBoxControllerHid::Buttons1::Y>(buttons1))
+			| GetButtonMask<ButtonEnum::L1>(GetButton<(uint8_t)XBoxControllerHid::Buttons1::L1>(buttons1))
+			| GetButtonMask<ButtonEnum::R1>(GetButton<(uint8_t)XBoxControllerHid::Buttons1::R1>(buttons1))
+			| GetButtonMask<ButtonEnum::Select>(GetButton<(uint8_t)XBoxControllerHid::Buttons2::Select>(buttons2))
+			| GetButtonMask<ButtonEnum::Start>(GetButton<(uint8_t)XBoxControllerHid::Buttons2::Start>(buttons2))
+			| GetButtonMask<ButtonEnum::L3>(GetButton<(uint8_t)XBoxControllerHid::Buttons2::L3>(buttons2))
+			| GetButtonMask<ButtonEnum::R3>(GetButton<(uint8_t)XBoxControllerHid::Buttons2::R3>(buttons2))
+			| GetButtonMask<ButtonEnum::Home>(GetButton<(uint8_t)XBoxControllerHid::Buttons2::Home>(buttons2))
+			| GetButtonMask<ButtonEnum::Share>(GetButton<(uint8_t)XBoxControllerHid::Buttons3::Share>(buttons3));
+
+		state.Flags = 1 << (uint8_t)PadBridge::StateFlagEnum::Connected;
+
+		return true;
 	}
 
 private:
+	static const int16_t GetAxis(const HidReport::FieldStruct& field, const int32_t value)
+	{
+		return (int32_t)HidReport::GetUnsigned(field, value) + INT16_MIN;
+	}
+
+	/// <summary>
+	/// HID Y axis grows downwards.
+	/// </summary>
+	static const int16_t GetAxisInverted(const HidReport::FieldStruct& field, const int32_t value)
+	{
+		return INT16_MAX - (int32_t)HidReport::GetUnsigned(field, value);
+	}
+
+	template<ButtonEnum Button>
+	static constexpr uint16_t GetButtonMask(const int32_t value)
+	{
+		return (uint16_t)(value != 0) << (uint8_t)Button;
+	}
+
 	template<uint8_t BitShift>
-	static constexpr bool GetButton(const uint8_t value)
+	static constexpr bool GetButton(const uint16_t value)
 	{
 		return (value >> (uint8_t)BitShift) & 1;
 	}
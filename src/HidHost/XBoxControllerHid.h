@@ -5,12 +5,20 @@
 
 #include <stdint.h>
 
+#include "HidReportParser.h"
+
 namespace XBoxControllerHid
 {
 	static constexpr uint8_t DataSize = 16;
 
 	static constexpr uint16_t TriggerMax = 1023;
 
+	/// <summary>
+	/// Fixed-point reciprocal to scale the triggers to [0 ; UINT16_MAX], rounded up so TriggerMax is full range.
+	/// </summary>
+	static constexpr uint8_t TriggerShift = 8;
+	static constexpr int16_t TriggerScale = (((uint32_t)UINT16_MAX << TriggerShift) + TriggerMax - 1) / TriggerMax;
+
 	static constexpr uint16_t JoyStickDeadZone = 1500;
 
 	enum class DPad : uint8_t
@@ -59,5 +67,64 @@ namespace XBoxControllerHid
 		Unknown6,
 		Unknown7
 	};
+
+	/// <summary>
+	/// Report map fingerprint: the compiled program reads every field of the XBox layout, at the XBox positions.
+	/// </summary>
+	inline const bool MatchesProgram(const HidReport::ProgramStruct& program)
+	{
+		struct LayoutStruct
+		{
+			HidReport::TargetEnum Target;
+			uint16_t BitOffset;
+			uint8_t BitSize;
+		};
+
+		static constexpr LayoutStruct Layout[] =
+		{
+			{ HidReport::TargetEnum::Joy1X, 0, 16 },
+			{ HidReport::TargetEnum::Joy1Y, 16, 16 },
+			{ HidReport::TargetEnum::Joy2X, 32, 16 },
+			{ HidReport::TargetEnum::Joy2Y, 48, 16 },
+			{ HidReport::TargetEnum::L2, 64, 10 },
+			{ HidReport::TargetEnum::R2, 80, 10 },
+			{ HidReport::TargetEnum::DPad, 96, 4 },
+			{ HidReport::TargetEnum::A, 104 + (uint8_t)Buttons1::A, 1 },
+			{ HidReport::TargetEnum::B, 104 + (uint8_t)Buttons1::B, 1 },
+			{ HidReport::TargetEnum::X, 104 + (uint8_t)Buttons1::X, 1 },
+			{ HidReport::TargetEnum::Y, 104 + (uint8_t)Buttons1::Y, 1 },
+			{ HidReport::TargetEnum::L1, 104 + (uint8_t)Buttons1::L1, 1 },
+			{ HidReport::TargetEnum::R1, 104 + (uint8_t)Buttons1::R1, 1 },
+			{ HidReport::TargetEnum::Select, 112 + (uint8_t)Buttons2::Select, 1 },
+			{ HidReport::TargetEnum::Start, 112 + (uint8_t)Buttons2::Start, 1 },
+			{ HidReport::TargetEnum::Home, 112 + (uint8_t)Buttons2::Home, 1 },
+			{ HidReport::TargetEnum::L3, 112 + (uint8_t)Buttons2::L3, 1 },
+			{ HidReport::TargetEnum::R3, 112 + (uint8_t)Buttons2::R3, 1 },
+			{ HidReport::TargetEnum::Share, 120 + (uint8_t)Buttons3::Share, 1 }
+		};
+
+		if (program.ReportSize != DataSize)
+		{
+			return false;
+		}
+
+		for (uint8_t i = 0; i < sizeof(Layout) / sizeof(Layout[0]); i++)
+		{
+			bool found = false;
+			for (uint8_t j = 0; j < program.Count; j++)
+			{
+				found |= program.Fields[j].Target == Layout[i].Target
+					&& program.Fields[j].BitOffset == Layout[i].BitOffset
+					&& program.Fields[j].BitSize == Layout[i].BitSize;
+			}
+
+			if (!found)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
 }
 #endif
@@ -0,0 +1,179 @@
+// VerticalDebounce.h
+
+#ifndef _VERTICAL_DEBOUNCE_h
+#define _VERTICAL_DEBOUNCE_h
+
+#include <stdint.h>
+
+enum class DebounceModeEnum : uint8_t
+{
+	/// <summary>
+	/// Raw input is passed through.
+	/// </summary>
+	None,
+
+	/// <summary>
+	/// Report on the first edge, then hold off further changes for Samples.
+	/// </summary>
+	Eager,
+
+	/// <summary>
+	/// Report after Samples consecutive samples in the new state.
+	/// </summary>
+	Integrating
+};
+
+/// <summary>
+/// Bit-parallel debounce engine, using vertical counters.
+/// Each bit of T is an independent input with its own counter, spread across the bit planes.
+/// All inputs are stepped together with a handful of bitwise operations per plane.
+/// </summary>
+/// <typeparam name="T">Unsigned input word, e.g. uint8_t or uint32_t.</typeparam>
+/// <typeparam name="Mode">Debounce mode.</typeparam>
+/// <typeparam name="Samples">Samples to settle (Integrating) or hold off (Eager) [1 ; 15].</typeparam>
+template<typename T, DebounceModeEnum Mode, uint8_t Samples>
+class VerticalDebounce
+{
+private:
+	static_assert(Mode == DebounceModeEnum::None || (Samples >= 1 && Samples <= 15), "Samples must be [1 ; 15].");
+
+	static constexpr uint8_t Planes = (Samples < 2) ? 1 : ((Samples < 4) ? 2 : ((Samples < 8) ? 3 : 4));
+
+private:
+	T Counter[Planes]{};
+	T State = 0;
+
+public:
+	void Clear(const T state = 0)
+	{
+		for (uint8_t i = 0; i < Planes; i++)
+		{
+			Counter[i] = 0;
+		}
+		State = state;
+	}
+
+	/// <summary>
+	/// Step all inputs with a new raw sample.
+	/// </summary>
+	/// <param name="raw">Raw input state.</param>
+	/// <returns>Debounced input state.</returns>
+	const T Step(const T raw)
+	{
+		switch (Mode)
+		{
+		case DebounceModeEnum::Eager:
+			return StepEager(raw);
+		case DebounceModeEnum::Integrating:
+			return StepIntegrating(raw);
+		case DebounceModeEnum::None:
+		default:
+			State = raw;
+			return raw;
+		}
+	}
+
+	const T Get() const
+	{
+		return State;
+	}
+
+private:
+	const T StepIntegrating(const T raw)
+	{
+		const T delta = raw ^ State;
+
+		// Count up inputs that differ from the state, reset the others.
+		T carry = delta;
+		for (uint8_t i = 0; i < Planes; i++)
+		{
+			const T plane = Counter[i];
+			Counter[i] = (plane ^ carry) & delta;
+			carry &= plane;
+		}
+
+		// Toggle inputs that reached Samples.
+		const T toggle = delta & CounterEquals();
+		State ^= toggle;
+		for (uint8_t i = 0; i < Planes; i++)
+		{
+			Counter[i] &= ~toggle;
+		}
+
+		return State;
+	}
+
+	const T StepEager(const T raw)
+	{
+		T locked = 0;
+		for (uint8_t i = 0; i < Planes; i++)
+		{
+			locked |= Counter[i];
+		}
+
+		// Count down the hold off of locked inputs.
+		T borrow = locked;
+		for (uint8_t i = 0; i < Planes; i++)
+		{
+			const T plane = Counter[i];
+			Counter[i] = plane ^ borrow;
+			borrow &= ~plane;
+		}
+
+		// Free inputs follow the first edge, then hold off for Samples.
+		const T toggle = (raw ^ State) & ~locked;
+		State ^= toggle;
+		for (uint8_t i = 0; i < Planes; i++)
+		{
+			if ((Samples >> i) & 1)
+			{
+				Counter[i] |= toggle;
+			}
+			else
+			{
+				Counter[i] &= ~toggle;
+			}
+		}
+
+		return State;
+	}
+
+	/// <summary>
+	/// Bit-parallel compare of all counters against Samples.
+	/// </summary>
+	const T CounterEquals() const
+	{
+		T equals = ~(T)0;
+		for (uint8_t i = 0; i < Planes; i++)
+		{
+			if ((Samples >> i) & 1)
+			{
+				equals &= Counter[i];
+			}
+			else
+			{
+				equals &= ~Counter[i];
+			}
+		}
+
+		return equals;
+	}
+};
+
+/// <summary>
+/// Compile-time debounce profile, applied to every input word of a device.
+/// </summary>
+/// <typeparam name="Mode">Debounce mode.</typeparam>
+/// <typeparam name="Samples">Samples to settle (Integrating) or hold off (Eager) [1 ; 15].</typeparam>
+template<DebounceModeEnum Mode = DebounceModeEnum::None, uint8_t Samples = 1>
+struct DebounceProfile
+{
+	template<typename T>
+	using Engine = VerticalDebounce<T, Mode, Samples>;
+};
+
+/// <summary>
+/// Pass-through profile.
+/// </summary>
+using DebounceNone = DebounceProfile<>;
+#endif
@@ -0,0 +1,279 @@
+// PadBridgeProtocol.h
+
+#ifndef _PAD_BRIDGE_PROTOCOL_h
+#define _PAD_BRIDGE_PROTOCOL_h
+
+#include <stdint.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "PadState.h"
+
+/// <summary>
+/// Slot-tagged pad bridge framing, between the host (this side) and the console adapter.
+/// Frame:
+///		[Header][Type:4 | Slot:4][Size][Payload, Size bytes][Crc]
+/// Crc is CRC-8 (0x07) over Type/Slot, Size and Payload.
+///
+/// Delta mode:
+///		Keyframe - [Seq][PadStateStruct]
+///		Delta - [Seq][BaseSeq][FieldMask, 2 bytes][changed fields, in FieldEnum order]
+///		Ack (adapter to host) - [Seq]
+///		Wake (adapter to host) - [0]
+///	Adapter frames all carry a single byte payload, so they're the same size (AdapterFrameSize).
+///	The adapter keeps the states it acknowledged and applies each delta to its BaseSeq state.
+///	A delta with an unknown base is dropped without an ack, the host falls back to a keyframe.
+/// </summary>
+namespace PadBridge
+{
+	static constexpr uint8_t Header = 0xA5;
+
+	static constexpr uint8_t MaxSlots = 16;
+
+	static constexpr uint32_t BaudRate = 1000000;
+	static constexpr uint32_t UpdatePeriodMillis = 8;
+
+	enum class ModeEnum : uint8_t
+	{
+		/// <summary>
+		/// Full state, every slot, every period.
+		/// </summary>
+		Full,
+
+		/// <summary>
+		/// Changed fields against the last acknowledged state, with periodic keyframes.
+		/// </summary>
+		Delta
+	};
+
+	/// <summary>
+	/// Sent states kept per slot as delta bases, power of 2.
+	/// </summary>
+	static constexpr uint8_t DeltaWindow = 8;
+
+	/// <summary>
+	/// Periods between forced keyframes, for resync.
+	/// </summary>
+	static constexpr uint8_t KeyframePeriods = 64;
+
+	/// <summary>
+	/// Minimum line spacing between notify-pushed updates.
+	/// </summary>
+	static constexpr uint32_t PushSpacingMicros = 1000;
+
+	enum class FrameTypeEnum : uint8_t
+	{
+		/// <summary>
+		/// Full PadStateStruct payload.
+		/// </summary>
+		State = 0,
+		Keyframe = 1,
+		Delta = 2,
+		Ack = 3,
+
+		/// <summary>
+		/// Adapter to host, one reserved byte (0). The console side is active, scan for controllers at full duty.
+		/// </summary>
+		Wake = 4
+	};
+
+	/// <summary>
+	/// PadStateStruct fields, as delta mask bits.
+	/// </summary>
+	enum class FieldEnum : uint8_t
+	{
+		Buttons,
+		Joy1X,
+		Joy1Y,
+		Joy2X,
+		Joy2Y,
+		L2,
+		R2,
+		DPad,
+		Flags,
+		FieldEnumCount
+	};
+
+	static constexpr uint8_t FrameOverhead = 4;
+
+	/// <summary>
+	/// Ack and Wake frame size.
+	/// </summary>
+	static constexpr uint8_t AdapterFrameSize = FrameOverhead + 1;
+	static constexpr uint8_t DeltaHeaderSize = 4;
+	static constexpr uint8_t MaxPayloadSize = DeltaHeaderSize + sizeof(PadStateStruct);
+	static constexpr uint8_t MaxFrameSize = FrameOverhead + MaxPayloadSize;
+
+	inline const uint8_t Crc8(const uint8_t* data, const uint8_t size)
+	{
+		uint8_t crc = 0;
+		for (uint8_t i = 0; i < size; i++)
+		{
+			crc ^= data[i];
+			for (uint8_t j = 0; j < 8; j++)
+			{
+				crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+			}
+		}
+
+		return crc;
+	}
+
+	/// <summary>
+	/// Frame the payload into the buffer.
+	/// </summary>
+	/// <param name="buffer">At least FrameOverhead + size bytes.</param>
+	/// <returns>Frame size.</returns>
+	inline const uint8_t Encode(uint8_t* buffer, const FrameTypeEnum type, const uint8_t slot, const void* payload, const uint8_t size)
+	{
+		buffer[0] = Header;
+		buffer[1] = ((uint8_t)type << 4) | (slot & 0x0F);
+		buffer[2] = size;
+		memcpy(&buffer[3], payload, size);
+		buffer[3 + size] = Crc8(&buffer[1], 2 + size);
+
+		return FrameOverhead + size;
+	}
+
+	inline const uint8_t GetFieldOffset(const FieldEnum field)
+	{
+		static constexpr uint8_t Offsets[(uint8_t)FieldEnum::FieldEnumCount] =
+		{
+			offsetof(PadStateStruct, Buttons),
+			offsetof(PadStateStruct, Joy1X),
+			offsetof(PadStateStruct, Joy1Y),
+			offsetof(PadStateStruct, Joy2X),
+			offsetof(PadStateStruct, Joy2Y),
+			offsetof(PadStateStruct, L2),
+			offsetof(PadStateStruct, R2),
+			offsetof(PadStateStruct, DPad),
+			offsetof(PadStateStruct, Flags)
+		};
+
+		return Offsets[(uint8_t)field];
+	}
+
+	inline const uint8_t GetFieldSize(const FieldEnum field)
+	{
+		return (field == FieldEnum::DPad || field == FieldEnum::Flags) ? 1 : 2;
+	}
+
+	/// <summary>
+	/// Delta payload of the fields that differ from the base.
+	/// </summary>
+	/// <param name="payload">At least MaxPayloadSize bytes.</param>
+	/// <returns>Payload size.</returns>
+	inline const uint8_t EncodeDelta(uint8_t* payload, const uint8_t seq, const uint8_t baseSeq,
+		const PadStateStruct& base, const PadStateStruct& state)
+	{
+		const uint8_t* from = (const uint8_t*)&base;
+		const uint8_t* to = (const uint8_t*)&state;
+
+		uint16_t mask = 0;
+		uint8_t size = DeltaHeaderSize;
+		for (uint8_t i = 0; i < (uint8_t)FieldEnum::FieldEnumCount; i++)
+		{
+			const uint8_t offset = GetFieldOffset((FieldEnum)i);
+			const uint8_t fieldSize = GetFieldSize((FieldEnum)i);
+			if (memcmp(&from[offset], &to[offset], fieldSize) != 0)
+			{
+				mask |= (uint16_t)1 << i;
+				memcpy(&payload[size], &to[offset], fieldSize);
+				size += fieldSize;
+			}
+		}
+
+		payload[0] = seq;
+		payload[1] = baseSeq;
+		payload[2] = mask & UINT8_MAX;
+		payload[3] = mask >> 8;
+
+		return size;
+	}
+
+	/// <summary>
+	/// Incoming frame parser, fed one byte at a time.
+	/// </summary>
+	class Decoder
+	{
+	private:
+		enum class StateEnum : uint8_t
+		{
+			Header,
+			TypeSlot,
+			Size,
+			Payload,
+			Crc
+		};
+
+	private:
+		uint8_t Buffer[2 + MaxPayloadSize]{};
+		uint8_t Index = 0;
+		StateEnum State = StateEnum::Header;
+
+	public:
+		/// <returns>True when a valid frame is complete.</returns>
+		const bool Feed(const uint8_t value)
+		{
+			switch (State)
+			{
+			case StateEnum::Header:
+				if (value == Header)
+				{
+					State = StateEnum::TypeSlot;
+				}
+				break;
+			case StateEnum::TypeSlot:
+				Buffer[0] = value;
+				State = StateEnum::Size;
+				break;
+			case StateEnum::Size:
+				Buffer[1] = value;
+				Index = 0;
+				if (value > MaxPayloadSize)
+				{
+					State = StateEnum::Header;
+				}
+				else
+				{
+					State = value > 0 ? StateEnum::Payload : StateEnum::Crc;
+				}
+				break;
+			case StateEnum::Payload:
+				Buffer[2 + Index++] = value;
+				if (Index >= Buffer[1])
+				{
+					State = StateEnum::Crc;
+				}
+				break;
+			case StateEnum::Crc:
+			default:
+				State = StateEnum::Header;
+				return value == Crc8(Buffer, 2 + Buffer[1]);
+			}
+
+			return false;
+		}
+
+		const FrameTypeEnum GetType() const
+		{
+			return (FrameTypeEnum)(Buffer[0] >> 4);
+		}
+
+		const uint8_t GetSlot() const
+		{
+			return Buffer[0] & 0x0F;
+		}
+
+		const uint8_t GetSize() const
+		{
+			return Buffer[1];
+		}
+
+		const uint8_t* GetPayload() const
+		{
+			return &Buffer[2];
+		}
+	};
+}
+#endif
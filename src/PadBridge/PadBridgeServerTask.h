@@ -0,0 +1,356 @@
+// PadBridgeServerTask.h
+
+#ifndef _PAD_BRIDGE_SERVER_TASK_h
+#define _PAD_BRIDGE_SERVER_TASK_h
+
+#if defined(_TASK_OO_CALLBACKS)
+#include <TSchedulerDeclarations.hpp>
+#include <Arduino.h>
+
+#include "../Framework/LatencyHistogram.h"
+#include "PadBridgeProtocol.h"
+
+/// <summary>
+/// Forwards every pad slot over a serial line, one slot-tagged frame per slot, each period.
+/// In delta mode, only the fields changed since the last acknowledged state are sent,
+/// unchanged and acknowledged slots are skipped and a keyframe is sent periodically or when the base is lost.
+/// With push enabled, a controller notification is forwarded from loop() as soon as the line spacing allows,
+/// instead of waiting for the next period. The periodic update is kept for keyframes and refresh.
+/// OnNotify must be called from the notification callback and Push from loop().
+/// </summary>
+/// <typeparam name="SerialType">Arduino serial.</typeparam>
+/// <typeparam name="PadType">VirtualPad source, with Update() to take the latest state.</typeparam>
+/// <typeparam name="SlotCount">Pad slots.</typeparam>
+template<typename SerialType, typename PadType, uint8_t SlotCount>
+class PadBridgeServerTask : private TS::Task
+{
+private:
+	static_assert(SlotCount > 0 && SlotCount <= PadBridge::MaxSlots, "Invalid bridge slot count.");
+	static_assert((PadBridge::DeltaWindow & (PadBridge::DeltaWindow - 1)) == 0, "Delta window must be a power of 2.");
+
+	static constexpr uint8_t WindowMask = PadBridge::DeltaWindow - 1;
+
+	struct SlotStruct
+	{
+		/// <summary>
+		/// Sent states, by Seq.
+		/// </summary>
+		PadBridge::PadStateStruct History[PadBridge::DeltaWindow];
+		uint8_t Seq;
+		uint8_t AckSeq;
+		uint8_t Periods;
+		bool Acked;
+	};
+
+private:
+	SerialType& SerialInstance;
+	PadType(&Pads)[SlotCount];
+
+private:
+	SlotStruct Slots[SlotCount]{};
+	PadBridge::Decoder Decoder{};
+	PadBridge::PadStateStruct State{};
+	uint8_t Payload[PadBridge::MaxPayloadSize]{};
+	uint8_t Frame[PadBridge::MaxFrameSize]{};
+
+	uint32_t BytesSent = 0;
+	uint32_t FramesSent = 0;
+	uint32_t KeyframesSent = 0;
+	uint32_t FramesDropped = 0;
+
+	PadBridge::ModeEnum Mode = PadBridge::ModeEnum::Full;
+
+private:
+	LatencyHistogram PushLatency{};
+	uint32_t PushSpacing = PadBridge::PushSpacingMicros;
+	uint32_t LastPush = 0;
+	volatile uint32_t NotifyTimestamp = 0;
+	volatile bool NotifyPending = false;
+	bool PushEnabled = false;
+	bool WakeRequested = false;
+
+public:
+	PadBridgeServerTask(TS::Scheduler& scheduler,
+		SerialType& serialInstance,
+		PadType(&pads)[SlotCount],
+		const uint32_t updatePeriod = PadBridge::UpdatePeriodMillis)
+		: TS::Task(updatePeriod, TASK_FOREVER, &scheduler, false)
+		, SerialInstance(serialInstance)
+		, Pads(pads)
+	{
+	}
+
+	const bool Setup(const uint32_t baudRate = PadBridge::BaudRate)
+	{
+		SerialInstance.begin(baudRate);
+
+		return true;
+	}
+
+	void Start()
+	{
+		TS::Task::enable();
+	}
+
+	void Stop()
+	{
+		TS::Task::disable();
+	}
+
+	/// <summary>
+	/// Switching mode restarts every slot from a keyframe.
+	/// </summary>
+	void SetMode(const PadBridge::ModeEnum mode)
+	{
+		Mode = mode;
+		for (uint8_t i = 0; i < SlotCount; i++)
+		{
+			Slots[i].Acked = false;
+		}
+	}
+
+	const PadBridge::ModeEnum GetMode() const
+	{
+		return Mode;
+	}
+
+	const uint32_t GetBytesSent() const
+	{
+		return BytesSent;
+	}
+
+	const uint32_t GetFramesSent() const
+	{
+		return FramesSent;
+	}
+
+	const uint32_t GetKeyframesSent() const
+	{
+		return KeyframesSent;
+	}
+
+	/// <summary>
+	/// Frames the serial didn't fully accept, e.g. the TX buffers were full.
+	/// Dropped delta frames are retried on the next update, from the same base.
+	/// </summary>
+	const uint32_t GetFramesDropped() const
+	{
+		return FramesDropped;
+	}
+
+	/// <summary>
+	/// </summary>
+	/// <param name="enabled">Forward on notify.</param>
+	/// <param name="spacingMicros">Minimum time between pushed updates.</param>
+	void SetPush(const bool enabled, const uint32_t spacingMicros = PadBridge::PushSpacingMicros)
+	{
+		PushSpacing = spacingMicros;
+		PushEnabled = enabled;
+		NotifyPending = false;
+	}
+
+	/// <summary>
+	/// Notification to UART write latency, of pushed updates.
+	/// </summary>
+	void GetPushLatency(LatencySummaryStruct& summary) const
+	{
+		PushLatency.GetSummary(summary);
+	}
+
+	void ClearPushLatency()
+	{
+		PushLatency.Clear();
+	}
+
+	/// <summary>
+	/// Notification callback context, flags a fresh state.
+	/// The first notification since the last push is timestamped.
+	/// </summary>
+	void OnNotify()
+	{
+		if (!NotifyPending)
+		{
+			NotifyTimestamp = micros();
+			NotifyPending = true;
+		}
+	}
+
+	/// <summary>
+	/// Forward the notified state now, if the spacing allows.
+	/// Runs in the same context as the scheduler, which owns the pads.
+	/// </summary>
+	void Push()
+	{
+		if (!PushEnabled
+			|| !NotifyPending)
+		{
+			return;
+		}
+
+		const uint32_t timestamp = micros();
+		if ((timestamp - LastPush) < PushSpacing)
+		{
+			return;
+		}
+
+		// Notifications after this point are carried by this update as well.
+		const uint32_t notifyTimestamp = NotifyTimestamp;
+		NotifyPending = false;
+		LastPush = timestamp;
+
+		SendSlots(false);
+		PushLatency.Add(micros() - notifyTimestamp);
+	}
+
+	/// <summary>
+	/// Parses the adapter acknowledges and wake requests, call when serial data is available.
+	/// </summary>
+	void OnSerialEvent()
+	{
+		while (SerialInstance.available() > 0)
+		{
+			if (!Decoder.Feed((uint8_t)SerialInstance.read()))
+			{
+				continue;
+			}
+
+			switch (Decoder.GetType())
+			{
+			case PadBridge::FrameTypeEnum::Ack:
+				if (Decoder.GetSlot() < SlotCount
+					&& Decoder.GetSize() >= 1)
+				{
+					OnAck(Slots[Decoder.GetSlot()], Decoder.GetPayload()[0]);
+				}
+				break;
+			case PadBridge::FrameTypeEnum::Wake:
+				WakeRequested = true;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	/// <summary>
+	/// Consumes the adapter wake request, if any.
+	/// </summary>
+	const bool TakeWakeRequest()
+	{
+		const bool requested = WakeRequested;
+		WakeRequested = false;
+
+		return requested;
+	}
+
+	virtual bool Callback() final
+	{
+		SendSlots(true);
+
+		return true;
+	}
+
+private:
+	/// <param name="period">Scheduled update, counts towards the keyframe period. Pushes don't.</param>
+	void SendSlots(const bool period)
+	{
+		for (uint8_t i = 0; i < SlotCount; i++)
+		{
+			Pads[i].Update();
+			PadBridge::ReadState(Pads[i], State);
+
+			switch (Mode)
+			{
+			case PadBridge::ModeEnum::Delta:
+				SendDelta(i, Slots[i], period);
+				break;
+			case PadBridge::ModeEnum::Full:
+			default:
+				Send(PadBridge::Encode(Frame, PadBridge::FrameTypeEnum::State, i, &State, sizeof(State)));
+				break;
+			}
+		}
+	}
+
+	void SendDelta(const uint8_t index, SlotStruct& slot, const bool period)
+	{
+		if (period
+			&& slot.Periods < UINT8_MAX)
+		{
+			slot.Periods++;
+		}
+
+		// The next Seq must not overwrite the acknowledged base.
+		const bool keyframe = !slot.Acked
+			|| (uint8_t)(slot.Seq - slot.AckSeq) >= WindowMask
+			|| slot.Periods >= PadBridge::KeyframePeriods;
+
+		if (!keyframe
+			&& slot.Seq == slot.AckSeq
+			&& memcmp(&slot.History[slot.Seq & WindowMask], &State, sizeof(State)) == 0)
+		{
+			// Adapter is up to date.
+			return;
+		}
+
+		const PadBridge::PadStateStruct& base = slot.History[slot.AckSeq & WindowMask];
+		const uint8_t seq = slot.Seq + 1;
+
+		uint8_t size;
+		PadBridge::FrameTypeEnum type;
+		if (keyframe)
+		{
+			Payload[0] = seq;
+			memcpy(&Payload[1], &State, sizeof(State));
+			size = 1 + sizeof(State);
+			type = PadBridge::FrameTypeEnum::Keyframe;
+		}
+		else
+		{
+			size = PadBridge::EncodeDelta(Payload, seq, slot.AckSeq, base, State);
+			type = PadBridge::FrameTypeEnum::Delta;
+		}
+
+		// The slot only moves on once the frame is on its way, so the adapter never misses a Seq.
+		if (Send(PadBridge::Encode(Frame, type, index, Payload, size)))
+		{
+			slot.Seq = seq;
+			slot.History[seq & WindowMask] = State;
+			if (keyframe)
+			{
+				slot.Periods = 0;
+				KeyframesSent++;
+			}
+		}
+	}
+
+	void OnAck(SlotStruct& slot, const uint8_t seq)
+	{
+		// Only states still in the window, never going back.
+		const uint8_t age = slot.Seq - seq;
+		if (age <= WindowMask
+			&& (!slot.Acked || (uint8_t)(seq - slot.AckSeq) <= WindowMask))
+		{
+			slot.AckSeq = seq;
+			slot.Acked = true;
+		}
+	}
+
+	/// <returns>True if the whole frame was accepted.</returns>
+	const bool Send(const uint8_t size)
+	{
+		if (SerialInstance.write(Frame, size) != size)
+		{
+			FramesDropped++;
+
+			return false;
+		}
+
+		BytesSent += size;
+		FramesSent++;
+
+		return true;
+	}
+};
+#endif
+#endif
@@ -0,0 +1,221 @@
+// PadBridgeUsb.h
+
+#ifndef _PAD_BRIDGE_USB_h
+#define _PAD_BRIDGE_USB_h
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "../Framework/LatencyHistogram.h"
+#include "../Framework/SpscMailbox.h"
+#include "../HidDevice/GamepadMapping.h"
+#include "../Usb/UsbHidGamepad.h"
+
+/// <summary>
+/// BLE to USB bridge latencies.
+/// </summary>
+struct __attribute__((packed)) PadBridgeUsbLatencyStruct
+{
+	/// <summary>
+	/// From controller notification to the report queued on the endpoint.
+	/// </summary>
+	LatencySummaryStruct Queue{};
+
+	/// <summary>
+	/// From controller notification to the report collected by the host, at start-of-frame resolution.
+	/// </summary>
+	LatencySummaryStruct Delivery{};
+};
+
+/// <summary>
+/// Re-exposes a BLE host pad as the USB HID gamepad.
+/// The pad is consumed from the USB start-of-frame, so a notification goes out on the very next frame,
+/// with no task period in between. Reports are only queued on change.
+/// OnNotify must be called from the notification callback and OnSofInterrupt from tud_sof_cb.
+/// The latency histograms are owned by the USB task, other tasks request a snapshot and read it once published.
+/// </summary>
+/// <typeparam name="PadType">VirtualPad source, with Update() to take the latest state.</typeparam>
+/// <typeparam name="MappingTable">GamepadMapping table.</typeparam>
+template<typename PadType, typename MappingTable>
+class PadBridgeUsb
+{
+private:
+	using Buttons = typename MappingTable::Buttons;
+
+private:
+	UsbHidGamepad& UsbGamepad;
+	PadType& Pad;
+
+private:
+	hid_gamepad_report_t Report{};
+	hid_gamepad_report_t LastReport{};
+	bool ReportPending = false;
+
+private:
+	LatencyHistogram QueueLatency{};
+	LatencyHistogram DeliveryLatency{};
+	SpscMailbox<PadBridgeUsbLatencyStruct> LatencySnapshot{};
+	std::atomic<bool> SnapshotRequested{ false };
+	std::atomic<bool> ClearRequested{ false };
+	volatile uint32_t NotifyTimestamp = 0;
+	volatile bool NotifyPending = false;
+	uint32_t EdgeTimestamp = 0;
+	uint32_t InFlightTimestamp = 0;
+	bool EdgePending = false;
+	bool InFlight = false;
+
+public:
+	PadBridgeUsb(UsbHidGamepad& usbGamepad, PadType& pad)
+		: UsbGamepad(usbGamepad)
+		, Pad(pad)
+	{
+	}
+
+	/// <summary>
+	/// Any task, a latency snapshot is published on the next start of frame.
+	/// </summary>
+	void RequestLatency()
+	{
+		SnapshotRequested.store(true, std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Single reader, latest snapshot published since the last call.
+	/// </summary>
+	/// <returns>False if no snapshot was published.</returns>
+	const bool GetLatency(PadBridgeUsbLatencyStruct& latency)
+	{
+		const PadBridgeUsbLatencyStruct* snapshot = LatencySnapshot.Take();
+		if (snapshot == nullptr)
+		{
+			return false;
+		}
+		latency = *snapshot;
+
+		return true;
+	}
+
+	/// <summary>
+	/// Any task, the histograms are cleared on the next start of frame.
+	/// </summary>
+	void ClearLatency()
+	{
+		ClearRequested.store(true, std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Notification callback context, timestamps the first notification since the last report.
+	/// </summary>
+	void OnNotify()
+	{
+		if (!NotifyPending)
+		{
+			NotifyTimestamp = micros();
+			NotifyPending = true;
+		}
+	}
+
+	/// <summary>
+	/// Start of frame, from the USB task. Sole consumer of the pad.
+	/// </summary>
+	void OnSofInterrupt()
+	{
+		ServiceLatency();
+
+		if (!UsbGamepad.IsReady())
+		{
+			return;
+		}
+
+		const uint32_t timestamp = micros();
+		if (InFlight)
+		{
+			// Endpoint is ready again, the previous report was collected.
+			InFlight = false;
+			DeliveryLatency.Add(timestamp - InFlightTimestamp);
+		}
+
+		if (NotifyPending)
+		{
+			if (!EdgePending)
+			{
+				EdgeTimestamp = NotifyTimestamp;
+				EdgePending = true;
+			}
+			NotifyPending = false;
+		}
+
+		if (Pad.Update())
+		{
+			UpdateReport();
+			ReportPending = ReportPending
+				|| memcmp(&Report, &LastReport, sizeof(hid_gamepad_report_t)) != 0;
+		}
+
+		if (ReportPending
+			&& UsbGamepad.NotifyGamepad(Report))
+		{
+			ReportPending = false;
+			LastReport = Report;
+
+			if (EdgePending)
+			{
+				EdgePending = false;
+				QueueLatency.Add(micros() - EdgeTimestamp);
+				InFlightTimestamp = EdgeTimestamp;
+				InFlight = true;
+			}
+		}
+		else if (!ReportPending)
+		{
+			// Nothing changed, e.g. a repeated notification.
+			EdgePending = false;
+		}
+	}
+
+private:
+	/// <summary>
+	/// Clear and snapshot requests, on the histograms' own task.
+	/// </summary>
+	void ServiceLatency()
+	{
+		if (ClearRequested.exchange(false, std::memory_order_relaxed))
+		{
+			QueueLatency.Clear();
+			DeliveryLatency.Clear();
+		}
+
+		if (SnapshotRequested.exchange(false, std::memory_order_relaxed))
+		{
+			PadBridgeUsbLatencyStruct& snapshot = LatencySnapshot.Reserve();
+			QueueLatency.GetSummary(snapshot.Queue);
+			DeliveryLatency.GetSummary(snapshot.Delivery);
+			LatencySnapshot.Commit();
+		}
+	}
+
+	void UpdateReport()
+	{
+		Report.buttons = Buttons::Get(Pad);
+		Report.hat = MappingTable::MapHat((uint8_t)Pad.DPad());
+
+		// HID Y axes point down.
+		Report.x = GetAxis(Pad.Joy1X());
+		Report.y = GetAxis((int16_t)~Pad.Joy1Y());
+		Report.z = GetAxis(Pad.Joy2X());
+		Report.rz = GetAxis((int16_t)~Pad.Joy2Y());
+		Report.rx = GetTrigger(Pad.L2());
+		Report.ry = GetTrigger(Pad.R2());
+	}
+
+	static const int8_t GetAxis(const int16_t value)
+	{
+		return (value >> 8) < -INT8_MAX ? -INT8_MAX : (value >> 8);
+	}
+
+	static const int8_t GetTrigger(const uint16_t value)
+	{
+		return GetAxis((int16_t)(value ^ 0x8000));
+	}
+};
+#endif
@@ -0,0 +1,75 @@
+// PadState.h
+
+#ifndef _PAD_STATE_h
+#define _PAD_STATE_h
+
+#include <stdint.h>
+
+namespace PadBridge
+{
+	enum class ButtonEnum : uint8_t
+	{
+		A,
+		B,
+		X,
+		Y,
+		L1,
+		R1,
+		L3,
+		R3,
+		Start,
+		Select,
+		Home,
+		Share
+	};
+
+	enum class StateFlagEnum : uint8_t
+	{
+		Connected = 0
+	};
+
+	/// <summary>
+	/// VirtualPad state snapshot, as sent over the bridge.
+	/// </summary>
+	struct __attribute__((packed)) PadStateStruct
+	{
+		uint16_t Buttons;
+		int16_t Joy1X;
+		int16_t Joy1Y;
+		int16_t Joy2X;
+		int16_t Joy2Y;
+		uint16_t L2;
+		uint16_t R2;
+		uint8_t DPad;
+		uint8_t Flags;
+	};
+
+	/// <summary>
+	/// Snapshot any VirtualPad.
+	/// </summary>
+	template<typename PadType>
+	void ReadState(PadType& pad, PadStateStruct& state)
+	{
+		state.Buttons = ((uint16_t)pad.A() << (uint8_t)ButtonEnum::A)
+			| ((uint16_t)pad.B() << (uint8_t)ButtonEnum::B)
+			| ((uint16_t)pad.X() << (uint8_t)ButtonEnum::X)
+			| ((uint16_t)pad.Y() << (uint8_t)ButtonEnum::Y)
+			| ((uint16_t)pad.L1() << (uint8_t)ButtonEnum::L1)
+			| ((uint16_t)pad.R1() << (uint8_t)ButtonEnum::R1)
+			| ((uint16_t)pad.L3() << (uint8_t)ButtonEnum::L3)
+			| ((uint16_t)pad.R3() << (uint8_t)ButtonEnum::R3)
+			| ((uint16_t)pad.Start() << (uint8_t)ButtonEnum::Start)
+			| ((uint16_t)pad.Select() << (uint8_t)ButtonEnum::Select)
+			| ((uint16_t)pad.Home() << (uint8_t)ButtonEnum::Home)
+			| ((uint16_t)pad.Share() << (uint8_t)ButtonEnum::Share);
+		state.Joy1X = pad.Joy1X();
+		state.Joy1Y = pad.Joy1Y();
+		state.Joy2X = pad.Joy2X();
+		state.Joy2Y = pad.Joy2Y();
+		state.L2 = pad.L2();
+		state.R2 = pad.R2();
+		state.DPad = (uint8_t)pad.DPad();
+		state.Flags = (uint8_t)pad.Connected() << (uint8_t)StateFlagEnum::Connected;
+	}
+}
+#endif
@@ -0,0 +1,385 @@
+// UarteTransport.h
+
+#ifndef _UARTE_TRANSPORT_h
+#define _UARTE_TRANSPORT_h
+
+#if defined(ARDUINO_ARCH_NRF52)
+#include <Arduino.h>
+#include <nrf.h>
+#include <nrf_soc.h>
+
+#if defined(NRF_UARTE1)
+#include "PadBridgeProtocol.h"
+
+/// <summary>
+/// UARTE transfer events, called from the interrupt.
+/// </summary>
+class IUarteListener
+{
+public:
+	/// <summary>
+	/// A TX buffer went out on the line.
+	/// </summary>
+	virtual void OnUarteTxComplete(const uint8_t size) {}
+
+	/// <summary>
+	/// At least one adapter frame worth of RX data is ready to read.
+	/// </summary>
+	virtual void OnUarteRxReady() {}
+};
+
+/// <summary>
+/// Pad bridge serial line on UARTE1, with EasyDMA on both directions.
+/// TX is double buffered: write() copies the frame into one buffer while the other is on the line,
+/// the buffers are swapped on the end of transfer interrupt, the line itself needs no CPU per byte.
+/// RX runs continuously into a single DMA ring: the ENDRX to STARTRX short restarts it on the same buffer,
+/// so there's no per-chunk pointer to re-arm from the interrupt, and no deadline under the SoftDevice.
+/// Received bytes are counted in hardware, RXDRDY drives a counter TIMER through PPI,
+/// and the ring is read in place up to the count, without stopping RX on idle.
+/// A byte is counted on RXDRDY, EasyDMA stores it within a few cycles, well before the reader gets to it.
+/// The TIMER compare wakes the reader once a whole adapter frame arrived after it caught up.
+/// Exposes the begin/write/available/read subset used by PadBridgeServerTask, as a drop in for the Arduino Uart.
+/// UARTE1_IRQHandler must be forwarded to OnUarteInterrupt and TIMER2_IRQHandler to OnTimerInterrupt,
+/// so Serial2 can't be used along with it.
+/// </summary>
+class UarteTransport
+{
+private:
+	static constexpr uint8_t TxBufferSize = 64;
+
+	/// <summary>
+	/// RX ring, power of 2. The reader must keep within one ring of the line, about 2.5 ms at 1 Mbaud.
+	/// </summary>
+	static constexpr uint16_t RxBufferSize = 256;
+
+	/// <summary>
+	/// Received bytes that wake the reader, one adapter frame.
+	/// </summary>
+	static constexpr uint8_t RxWakeBytes = PadBridge::AdapterFrameSize;
+
+	static_assert((RxBufferSize & (RxBufferSize - 1)) == 0, "RX ring must be a power of 2.");
+	static_assert(RxBufferSize > RxWakeBytes, "RX ring must hold a frame.");
+
+	/// <summary>
+	/// Application interrupt priority, lowest allowed with the SoftDevice.
+	/// </summary>
+	static constexpr uint8_t IrqPriority = 6;
+
+	/// <summary>
+	/// PPI channel from RXDRDY to the counter, outside of the SoftDevice reserved range.
+	/// </summary>
+	static constexpr uint8_t RxPpiChannel = 0;
+
+	/// <summary>
+	/// Counter TIMER compare and capture registers.
+	/// </summary>
+	static constexpr uint8_t RxWakeCompare = 0;
+	static constexpr uint8_t RxCountCapture = 1;
+
+private:
+	const uint32_t RxPin;
+	const uint32_t TxPin;
+
+private:
+	IUarteListener* Listener = nullptr;
+
+private:
+	// EasyDMA buffers, must be in RAM.
+	uint8_t TxBuffers[2][TxBufferSize]{};
+	uint8_t RxBuffer[RxBufferSize]{};
+
+	volatile uint8_t TxLength[2]{};
+	volatile uint8_t TxFill = 0;
+	volatile bool TxBusy = false;
+
+	uint32_t RxRead = 0;
+
+private:
+	uint32_t TxDropped = 0;
+	uint32_t RxOverruns = 0;
+	volatile uint32_t Errors = 0;
+
+public:
+	UarteTransport(const uint8_t rxPin, const uint8_t txPin)
+		: RxPin(g_ADigitalPinMap[rxPin])
+		, TxPin(g_ADigitalPinMap[txPin])
+	{
+	}
+
+	void SetListener(IUarteListener* listener)
+	{
+		Listener = listener;
+	}
+
+	void begin(const uint32_t baudRate)
+	{
+		end();
+
+		NRF_UARTE1->PSEL.TXD = TxPin;
+		NRF_UARTE1->PSEL.RXD = RxPin;
+		NRF_UARTE1->PSEL.CTS = UARTE_PSEL_CTS_CONNECT_Disconnected << UARTE_PSEL_CTS_CONNECT_Pos;
+		NRF_UARTE1->PSEL.RTS = UARTE_PSEL_RTS_CONNECT_Disconnected << UARTE_PSEL_RTS_CONNECT_Pos;
+		NRF_UARTE1->CONFIG = 0;
+		NRF_UARTE1->BAUDRATE = GetBaudRegister(baudRate);
+		NRF_UARTE1->ENABLE = UARTE_ENABLE_ENABLE_Enabled << UARTE_ENABLE_ENABLE_Pos;
+
+		TxLength[0] = 0;
+		TxLength[1] = 0;
+		TxFill = 0;
+		TxBusy = false;
+		RxRead = 0;
+
+		NRF_UARTE1->EVENTS_ENDTX = 0;
+		NRF_UARTE1->EVENTS_ENDRX = 0;
+		NRF_UARTE1->EVENTS_RXDRDY = 0;
+		NRF_UARTE1->EVENTS_ERROR = 0;
+
+		// Received byte counter.
+		NRF_TIMER2->MODE = TIMER_MODE_MODE_LowPowerCounter << TIMER_MODE_MODE_Pos;
+		NRF_TIMER2->BITMODE = TIMER_BITMODE_BITMODE_32Bit << TIMER_BITMODE_BITMODE_Pos;
+		NRF_TIMER2->TASKS_CLEAR = 1;
+		NRF_TIMER2->EVENTS_COMPARE[RxWakeCompare] = 0;
+		NRF_TIMER2->CC[RxWakeCompare] = RxWakeBytes;
+		NRF_TIMER2->INTENSET = TIMER_INTENSET_COMPARE0_Msk;
+		NRF_TIMER2->TASKS_START = 1;
+
+		sd_ppi_channel_assign(RxPpiChannel, &NRF_UARTE1->EVENTS_RXDRDY, &NRF_TIMER2->TASKS_COUNT);
+		sd_ppi_channel_enable_set(1UL << RxPpiChannel);
+
+		// The short restarts RX on the same ring at each end, without losing a byte.
+		NRF_UARTE1->SHORTS = UARTE_SHORTS_ENDRX_STARTRX_Msk;
+		NRF_UARTE1->INTENSET = UARTE_INTENSET_ENDTX_Msk
+			| UARTE_INTENSET_ERROR_Msk;
+
+		sd_nvic_ClearPendingIRQ(UARTE1_IRQn);
+		sd_nvic_SetPriority(UARTE1_IRQn, IrqPriority);
+		sd_nvic_EnableIRQ(UARTE1_IRQn);
+
+		sd_nvic_ClearPendingIRQ(TIMER2_IRQn);
+		sd_nvic_SetPriority(TIMER2_IRQn, IrqPriority);
+		sd_nvic_EnableIRQ(TIMER2_IRQn);
+
+		NRF_UARTE1->RXD.PTR = (uint32_t)RxBuffer;
+		NRF_UARTE1->RXD.MAXCNT = RxBufferSize;
+		NRF_UARTE1->TASKS_STARTRX = 1;
+	}
+
+	void end()
+	{
+		sd_nvic_DisableIRQ(UARTE1_IRQn);
+		NRF_UARTE1->INTENCLR = UINT32_MAX;
+		NRF_UARTE1->SHORTS = 0;
+
+		sd_nvic_DisableIRQ(TIMER2_IRQn);
+		sd_ppi_channel_enable_clr(1UL << RxPpiChannel);
+		NRF_TIMER2->INTENCLR = UINT32_MAX;
+		NRF_TIMER2->TASKS_STOP = 1;
+
+		if (NRF_UARTE1->ENABLE != 0)
+		{
+			NRF_UARTE1->TASKS_STOPTX = 1;
+			NRF_UARTE1->TASKS_STOPRX = 1;
+			NRF_UARTE1->ENABLE = UARTE_ENABLE_ENABLE_Disabled << UARTE_ENABLE_ENABLE_Pos;
+		}
+	}
+
+	/// <summary>
+	/// Queue bytes for the line, starts the DMA if idle.
+	/// </summary>
+	/// <returns>Queued bytes, 0 if both buffers are taken.</returns>
+	size_t write(const uint8_t* data, const size_t size)
+	{
+		if (size == 0
+			|| size > TxBufferSize)
+		{
+			return 0;
+		}
+
+		sd_nvic_DisableIRQ(UARTE1_IRQn);
+		const uint8_t fill = TxFill;
+		if (((size_t)TxLength[fill] + size) > TxBufferSize)
+		{
+			sd_nvic_EnableIRQ(UARTE1_IRQn);
+			TxDropped++;
+
+			return 0;
+		}
+
+		memcpy(&TxBuffers[fill][TxLength[fill]], data, size);
+		TxLength[fill] += size;
+
+		if (!TxBusy)
+		{
+			StartTx();
+		}
+		sd_nvic_EnableIRQ(UARTE1_IRQn);
+
+		return size;
+	}
+
+	int available()
+	{
+		const uint32_t received = GetRxCount();
+		if ((received - RxRead) > RxBufferSize)
+		{
+			// The DMA went over unread bytes, skip to the intact half of the ring.
+			RxRead = received - (RxBufferSize / 2);
+			RxOverruns++;
+		}
+
+		if (received == RxRead)
+		{
+			ArmRxWake();
+
+			return 0;
+		}
+
+		return received - RxRead;
+	}
+
+	int read()
+	{
+		if (available() <= 0)
+		{
+			return -1;
+		}
+
+		return RxBuffer[RxRead++ & (RxBufferSize - 1)];
+	}
+
+	/// <summary>
+	/// Writes rejected because both TX buffers were taken.
+	/// </summary>
+	const uint32_t GetTxDropped() const
+	{
+		return TxDropped;
+	}
+
+	/// <summary>
+	/// RX ring overruns, because the consumer fell behind.
+	/// </summary>
+	const uint32_t GetRxOverruns() const
+	{
+		return RxOverruns;
+	}
+
+	/// <summary>
+	/// Line errors, e.g. framing or break.
+	/// </summary>
+	const uint32_t GetErrors() const
+	{
+		return Errors;
+	}
+
+	void OnUarteInterrupt()
+	{
+		if (NRF_UARTE1->EVENTS_ENDTX)
+		{
+			NRF_UARTE1->EVENTS_ENDTX = 0;
+			TxBusy = false;
+
+			const uint8_t sent = NRF_UARTE1->TXD.AMOUNT;
+			if (TxLength[TxFill] > 0)
+			{
+				StartTx();
+			}
+
+			if (Listener != nullptr)
+			{
+				Listener->OnUarteTxComplete(sent);
+			}
+		}
+
+		if (NRF_UARTE1->EVENTS_ERROR)
+		{
+			NRF_UARTE1->EVENTS_ERROR = 0;
+			NRF_UARTE1->ERRORSRC = NRF_UARTE1->ERRORSRC;
+			Errors++;
+		}
+	}
+
+	void OnTimerInterrupt()
+	{
+		NRF_TIMER2->EVENTS_COMPARE[RxWakeCompare] = 0;
+
+		if (Listener != nullptr)
+		{
+			Listener->OnUarteRxReady();
+		}
+	}
+
+private:
+	/// <summary>
+	/// Received bytes since begin(), wraps along with RxRead.
+	/// </summary>
+	const uint32_t GetRxCount() const
+	{
+		NRF_TIMER2->TASKS_CAPTURE[RxCountCapture] = 1;
+
+		return NRF_TIMER2->CC[RxCountCapture];
+	}
+
+	/// <summary>
+	/// Compare on the next adapter frame past the read position.
+	/// If it arrived while arming, the compare already went by, pend the interrupt instead.
+	/// </summary>
+	void ArmRxWake()
+	{
+		const uint32_t target = RxRead + RxWakeBytes;
+		if (NRF_TIMER2->CC[RxWakeCompare] == target)
+		{
+			return;
+		}
+
+		NRF_TIMER2->CC[RxWakeCompare] = target;
+		if ((GetRxCount() - RxRead) >= RxWakeBytes)
+		{
+			sd_nvic_SetPendingIRQ(TIMER2_IRQn);
+		}
+	}
+
+	/// <summary>
+	/// Sends the fill buffer and swaps, called with the interrupt masked or from it.
+	/// </summary>
+	void StartTx()
+	{
+		const uint8_t buffer = TxFill;
+		TxFill = buffer ^ 1;
+		TxLength[TxFill] = 0;
+		TxBusy = true;
+
+		NRF_UARTE1->TXD.PTR = (uint32_t)TxBuffers[buffer];
+		NRF_UARTE1->TXD.MAXCNT = TxLength[buffer];
+		NRF_UARTE1->TASKS_STARTTX = 1;
+	}
+
+	/// <summary>
+	/// Nearest supported baud rate, at or below the requested one.
+	/// </summary>
+	static const uint32_t GetBaudRegister(const uint32_t baudRate)
+	{
+		if (baudRate >= 1000000)
+			return UARTE_BAUDRATE_BAUDRATE_Baud1M;
+		else if (baudRate >= 921600)
+			return UARTE_BAUDRATE_BAUDRATE_Baud921600;
+		else if (baudRate >= 460800)
+			return UARTE_BAUDRATE_BAUDRATE_Baud460800;
+		else if (baudRate >= 250000)
+			return UARTE_BAUDRATE_BAUDRATE_Baud250000;
+		else if (baudRate >= 230400)
+			return UARTE_BAUDRATE_BAUDRATE_Baud230400;
+		else if (baudRate >= 115200)
+			return UARTE_BAUDRATE_BAUDRATE_Baud115200;
+		else if (baudRate >= 57600)
+			return UARTE_BAUDRATE_BAUDRATE_Baud57600;
+		else if (baudRate >= 38400)
+			return UARTE_BAUDRATE_BAUDRATE_Baud38400;
+		else if (baudRate >= 19200)
+			return UARTE_BAUDRATE_BAUDRATE_Baud19200;
+		else
+			return UARTE_BAUDRATE_BAUDRATE_Baud9600;
+	}
+};
+#endif
+#endif
+#endif
@@ -12,6 +12,37 @@
 
 namespace SeeedXIAOnRF52840
 {
+	/// <summary>
+	/// Compile-time Arduino pin to nRF52 port pin map (Port * 32 + Bit).
+	/// Mirrors the variant's g_ADigitalPinMap for the exposed pads.
+	/// </summary>
+	struct PortMap
+	{
+	private:
+		static constexpr uint8_t P1 = 32;
+
+		static constexpr uint8_t PortPins[] =
+		{
+			2,		// D0 is P0.02
+			3,		// D1 is P0.03
+			28,		// D2 is P0.28
+			29,		// D3 is P0.29
+			4,		// D4 is P0.04
+			5,		// D5 is P0.05
+			P1 + 11,// D6 is P1.11
+			P1 + 12,// D7 is P1.12
+			P1 + 13,// D8 is P1.13
+			P1 + 14,// D9 is P1.14
+			P1 + 15	// D10 is P1.15
+		};
+
+	public:
+		static constexpr uint8_t GetPortPin(const uint8_t pin)
+		{
+			return PortPins[pin];
+		}
+	};
+
 	/// <summary>
 	/// Onboard LED tied to IO.
 	/// </summary>
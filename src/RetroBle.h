@@ -11,6 +11,10 @@
 #endif
 
 #include "Framework/RetroBleDevice.h"
+#include "Framework/InternalFile.h"
+
+#include "Gpio/PortCapture.h"
+#include "Gpio/DPadCapture.h"
 
 #include "BatteryManager/IBatteryManager.h"
 #include "BatteryManager/BatteryState.h"
@@ -26,22 +30,43 @@
 #include "Indicator/LedAnimator.h"
 
 #include "Ble/IBleListener.h"
+#include "Ble/BleTxOrder.h"
 #include "Ble/BleConfig.h"
+#include "Ble/BleRadioSync.h"
 #include "Ble/BlePeripheral.h"
+#include "Ble/BlePeerCache.h"
 #include "Ble/BleCentral.h"
 
 #include "Usb/IUsbListener.h"
 #include "Usb/UsbConfig.h"
 #include "Usb/UsbPeripheral.h"
+#include "Usb/UsbSofSync.h"
 
 #include "Usb/UsbHidGamepad.h"
 #include "Usb/UsbHidKeyboard.h"
 
+#include "Input/VerticalDebounce.h"
+
 #include "HidDevice/HidGamepadTask.h"
 #include "HidDevice/HidKeyboardTask.h"
+#include "HidDevice/GamepadMapping.h"
+#include "HidDevice/GamepadRemap.h"
+#include "HidDevice/GamepadRemapConsole.h"
+#include "HidDevice/GamepadMapperTask.h"
 
+#include "Analog/AxisKernels.h"
+#include "Analog/AnalogCurve.h"
+#include "Analog/AnalogProcessor.h"
+
+#include "HidHost/HidReportParser.h"
 #include "HidHost/HidToVirtualPad.h"
 
+#include "PadBridge/PadState.h"
+#include "PadBridge/PadBridgeProtocol.h"
+#include "PadBridge/PadBridgeServerTask.h"
+#include "PadBridge/UarteTransport.h"
+#include "PadBridge/PadBridgeUsb.h"
+
 #include "Framework/UsbBleCoordinator.h"
 
 
@@ -10,4 +10,13 @@ struct IUsbListener
 
 	virtual void OnUsbBackReport(uint8_t report_id, uint8_t report_type, uint8_t const* buffer, uint16_t bufsize) = 0;
 };
+
+/// <summary>
+/// Listener for the start-of-frame sampling point, called from the USB task.
+/// Not the scheduler context, hand over through an atomic flag.
+/// </summary>
+struct IUsbSofListener
+{
+	virtual void OnUsbSampleDue() = 0;
+};
 #endif
\ No newline at end of file
@@ -0,0 +1,242 @@
+#ifndef _USB_SOF_SYNC_h
+#define _USB_SOF_SYNC_h
+
+#include <Adafruit_LittleFS.h>
+#include <InternalFileSystem.h>
+#include <Adafruit_TinyUSB.h>
+
+#include "UsbConfig.h"
+#include "IUsbListener.h"
+
+/// <summary>
+/// USB pacing counters.
+/// </summary>
+struct UsbSofStatsStruct
+{
+	/// <summary>
+	/// Start-of-frame callbacks that never arrived, USB task fell behind.
+	/// </summary>
+	uint32_t FramesMissed = 0;
+
+	/// <summary>
+	/// Polls without a fresh sample ahead of them, the input task was late.
+	/// </summary>
+	uint32_t PollsLate = 0;
+
+	/// <summary>
+	/// Polls sampled more than once.
+	/// </summary>
+	uint32_t SamplesDuplicated = 0;
+
+	/// <summary>
+	/// Samples taken while the previous report was still waiting for its poll.
+	/// </summary>
+	uint32_t EndpointBusy = 0;
+};
+
+/// <summary>
+/// Tracks the USB start-of-frame (1 ms full speed) and the endpoint poll phase.
+/// The poll frame is learned from the endpoint becoming ready again after a report was queued,
+/// so the input can be sampled on the start-of-frame a fixed number of frames before the next poll.
+/// The listener is signaled on that start-of-frame, from the USB task, and must only hand it over.
+/// tud_sof_cb must be forwarded to OnSofInterrupt.
+/// </summary>
+class UsbSofSync
+{
+private:
+	static constexpr uint16_t FrameMask = 0x7FF;
+	static constexpr uint32_t FrameMicros = 1000;
+
+public:
+	/// <summary>
+	/// Start-of-frame missing for this many frames drops the lock, e.g. on suspend.
+	/// </summary>
+	static constexpr uint8_t LockTimeoutFrames = 4;
+
+private:
+	const uint8_t PollPeriod;
+	const uint8_t LeadFrames;
+
+private:
+	IUsbSofListener* Listener = nullptr;
+
+private:
+	volatile uint32_t Timestamp = 0;
+	volatile uint32_t Count = 0;
+	volatile uint16_t Frame = 0;
+	volatile uint16_t PollFrame = 0;
+	volatile uint16_t DueFrame = 0;
+	volatile bool Due = false;
+	volatile bool InFlight = false;
+
+private:
+	UsbSofStatsStruct Stats{};
+	uint16_t LastSampleFrame = 0;
+	bool Sampled = false;
+
+public:
+	/// <summary>
+	/// </summary>
+	/// <param name="leadFrames">Input is sampled on the start-of-frame this many frames before the polled one, [1 ; pollPeriod].</param>
+	/// <param name="pollPeriod">Endpoint poll period, in frames.</param>
+	UsbSofSync(const uint8_t leadFrames = 1, const uint8_t pollPeriod = RetroBle::UsbConfig::PollPeriod)
+		: PollPeriod(pollPeriod > 0 ? pollPeriod : 1)
+		, LeadFrames(leadFrames < 1 ? 1 : (leadFrames > PollPeriod ? PollPeriod : leadFrames))
+	{}
+
+	/// <summary>
+	/// Woken on the sampling point ahead of each poll.
+	/// </summary>
+	void SetListener(IUsbSofListener* listener)
+	{
+		Listener = listener;
+	}
+
+	void Setup()
+	{
+		tud_sof_cb_enable(true);
+	}
+
+	/// <summary>
+	/// Start of frame, from the USB task.
+	/// </summary>
+	/// <param name="frameCount">11 bit frame number.</param>
+	/// <param name="endpointReady">Report endpoint state.</param>
+	void OnSofInterrupt(const uint32_t frameCount, const bool endpointReady)
+	{
+		const uint16_t frame = frameCount & FrameMask;
+
+		if (Count > 0)
+		{
+			const uint16_t elapsed = (frame - Frame) & FrameMask;
+			if (elapsed > 1)
+			{
+				Stats.FramesMissed += elapsed - 1;
+			}
+		}
+
+		if (InFlight
+			&& endpointReady)
+		{
+			// Report was collected during the previous frame.
+			InFlight = false;
+			PollFrame = (frame - 1) & FrameMask;
+		}
+
+		Timestamp = micros();
+		Frame = frame;
+		Count++;
+
+		// The current frame is already being polled, next one is at least a frame away.
+		uint16_t offset = ((PollFrame - frame) & FrameMask) % PollPeriod;
+		if (offset == 0)
+		{
+			offset = PollPeriod;
+		}
+
+		if (offset == LeadFrames)
+		{
+			DueFrame = (frame + offset) & FrameMask;
+			Due = true;
+
+			if (Listener != nullptr)
+			{
+				Listener->OnUsbSampleDue();
+			}
+		}
+	}
+
+	/// <summary>
+	/// A report was queued to the endpoint, its completion updates the poll phase.
+	/// </summary>
+	void OnReportQueued()
+	{
+		InFlight = true;
+	}
+
+	/// <summary>
+	/// Start-of-frame is running.
+	/// </summary>
+	/// <param name="timestamp">Current micros().</param>
+	const bool IsLocked(const uint32_t timestamp) const
+	{
+		return Count > 0
+			&& (timestamp - Timestamp) < (FrameMicros * LockTimeoutFrames);
+	}
+
+	/// <summary>
+	/// A sampling point was signaled and not taken yet.
+	/// </summary>
+	const bool IsSampleDue() const
+	{
+		return Due;
+	}
+
+	/// <summary>
+	/// Take the pending sampling point, each poll is only handed out once.
+	/// </summary>
+	/// <param name="endpointReady">False if the previous report is still waiting for its poll.</param>
+	/// <returns>True if input should be sampled now for the upcoming poll.</returns>
+	const bool TakeSample(const bool endpointReady)
+	{
+		if (!Due)
+		{
+			return false;
+		}
+
+		Due = false;
+		const uint16_t pollFrame = DueFrame;
+
+		// Left pending while the sampler skipped polls, e.g. on an idle tier.
+		const uint16_t ahead = (pollFrame - Frame) & FrameMask;
+		if (ahead == 0
+			|| ahead > LeadFrames)
+		{
+			return false;
+		}
+
+		OnPollSample(pollFrame, endpointReady);
+
+		return true;
+	}
+
+	void GetStats(UsbSofStatsStruct& stats) const
+	{
+		stats = Stats;
+	}
+
+	void ClearStats()
+	{
+		Stats = {};
+	}
+
+private:
+	/// <summary>
+	/// Input was sampled for the poll frame.
+	/// </summary>
+	void OnPollSample(const uint16_t pollFrame, const bool endpointReady)
+	{
+		if (Sampled)
+		{
+			const uint16_t elapsed = (pollFrame - LastSampleFrame) & FrameMask;
+
+			if (elapsed == 0)
+			{
+				Stats.SamplesDuplicated++;
+			}
+			else if (elapsed > PollPeriod)
+			{
+				Stats.PollsLate += (elapsed / PollPeriod) - 1;
+			}
+		}
+
+		if (!endpointReady)
+		{
+			Stats.EndpointBusy++;
+		}
+
+		LastSampleFrame = pollFrame;
+		Sampled = true;
+	}
+};
+#endif